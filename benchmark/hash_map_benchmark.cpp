@@ -0,0 +1,436 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "task1.cpp"
+
+#ifdef HASH_MAP_BENCHMARK_ABSL
+#include <absl/container/flat_hash_map.h>
+#endif
+
+#ifndef HASH_MAP_BENCHMARK_MAX_SIZE
+#define HASH_MAP_BENCHMARK_MAX_SIZE 100000000
+#endif
+
+namespace {
+
+// Largest number of items of maps with string keys, which take several times more memory than integer ones.
+constexpr size_t MaxStringSize = 10000000;
+// Largest number of items of maps shared by threads.
+constexpr size_t MaxConcurrentSize = 10000000;
+
+// Key distribution. Adversarial keys differ only in high bits for integers, so that identity hashes
+// masked by a power of two collide, and only in the last characters of a long common prefix for strings.
+enum class Distribution { Random, Adversarial };
+
+// Returns i-th key of distribution D with seed Seed. Keys of different i are different.
+template<class Key>
+Key make_key(size_t i, Distribution D, uint64_t Seed);
+
+template<>
+uint64_t make_key<uint64_t>(size_t i, Distribution D, uint64_t Seed) {
+    if (D == Distribution::Adversarial) {
+        return static_cast<uint64_t>(i) << 32 | Seed;
+    }
+    // Multiplication by an odd number is a bijection, so different i give different keys.
+    return MurmurHashMixer()(i * 0x9e3779b97f4a7c15ULL + Seed);
+}
+
+template<>
+std::string make_key<std::string>(size_t i, Distribution D, uint64_t Seed) {
+    if (D == Distribution::Adversarial) {
+        return "service/region/cluster/instance/session/" + std::to_string(Seed) + "/" + std::to_string(i);
+    }
+    return std::to_string(make_key<uint64_t>(i, D, Seed));
+}
+
+// Returns n different keys of distribution D in random order. Keys of different seeds are different.
+template<class Key>
+std::vector<Key> make_keys(size_t n, Distribution D, uint64_t Seed) {
+    std::vector<Key> Keys;
+    Keys.reserve(n);
+    for (size_t i = 0; i != n; ++i) {
+        Keys.push_back(make_key<Key>(i, D, Seed));
+    }
+    std::shuffle(Keys.begin(), Keys.end(), std::mt19937_64(Seed));
+    return Keys;
+}
+
+#ifdef HASH_MAP_MMAP
+// PageResource with huge pages Mode shared by every benchmarked map using it for the whole run.
+template<HugePages Mode>
+struct BenchmarkPageResource: PageResource {
+    BenchmarkPageResource(): PageResource(Mode) {}
+    // Returns the resource of Mode.
+    static BenchmarkPageResource& get() {
+        static BenchmarkPageResource Resource;
+        return Resource;
+    }
+};
+
+// PageAllocator of the shared resource of huge pages Pages, so that maps using it are made like maps of other allocators.
+template<class T, HugePages Pages>
+using BenchmarkPageAllocator = ResourceAllocator<T, BenchmarkPageResource<Pages>>;
+#endif
+
+// Shared resource of maps using allocator A, or void for allocators without one.
+template<class A>
+struct BenchmarkResource {
+    typedef void type;
+};
+#ifdef HASH_MAP_MMAP
+template<class T, HugePages Pages>
+struct BenchmarkResource<BenchmarkPageAllocator<T, Pages>> {
+    typedef BenchmarkPageResource<Pages> type;
+};
+#endif
+
+// Returns an empty map, using the shared resource of its allocator if it has one.
+template<class Map>
+Map make_empty_map() {
+    typedef typename BenchmarkResource<typename Map::allocator_type>::type Resource;
+    if constexpr (std::is_void<Resource>::value) {
+        return Map();
+    } else {
+        return Map(typename Map::allocator_type(Resource::get()));
+    }
+}
+
+// Returns map of keys Keys with values 0, 1, and so on.
+template<class Map, class Key>
+Map make_map(const std::vector<Key>& Keys) {
+    Map m = make_empty_map<Map>();
+    for (size_t i = 0; i != Keys.size(); ++i) {
+        m.emplace(Keys[i], static_cast<int64_t>(i));
+    }
+    return m;
+}
+
+// Inserts n keys into an empty map.
+template<class Map, class Key>
+void insert_benchmark(benchmark::State& State, Distribution D) {
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1);
+    for (auto _ : State) {
+        Map m;
+        for (const Key& k : Keys) {
+            m.emplace(k, 0);
+        }
+        benchmark::DoNotOptimize(m);
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Looks up every stored key in an order unrelated to insertion.
+template<class Map, class Key>
+void find_hit_benchmark(benchmark::State& State, Distribution D) {
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1);
+    auto m = make_map<Map>(Keys);
+    std::shuffle(Keys.begin(), Keys.end(), std::mt19937_64(2));
+    for (auto _ : State) {
+        for (const Key& k : Keys) {
+            benchmark::DoNotOptimize(m.find(k));
+        }
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Looks up as many absent keys as the map stores.
+template<class Map, class Key>
+void find_miss_benchmark(benchmark::State& State, Distribution D) {
+    auto m = make_map<Map>(make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1));
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 3);
+    for (auto _ : State) {
+        for (const Key& k : Keys) {
+            benchmark::DoNotOptimize(m.find(k));
+        }
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Erases every key of a full map. Building the map is not timed.
+template<class Map, class Key>
+void erase_benchmark(benchmark::State& State, Distribution D) {
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1);
+    for (auto _ : State) {
+        State.PauseTiming();
+        auto m = make_map<Map>(Keys);
+        State.ResumeTiming();
+        for (const Key& k : Keys) {
+            m.erase(k);
+        }
+        benchmark::DoNotOptimize(m);
+        State.PauseTiming();
+        m = Map();
+        State.ResumeTiming();
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Sums values of every item.
+template<class Map, class Key>
+void iterate_benchmark(benchmark::State& State, Distribution D) {
+    auto m = make_map<Map>(make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1));
+    for (auto _ : State) {
+        int64_t Sum = 0;
+        for (auto&& Item : m) {
+            Sum += Item.second;
+        }
+        benchmark::DoNotOptimize(Sum);
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Doubles number of buckets and shrinks them back to fit, moving every item twice.
+template<class Map, class Key>
+void rehash_benchmark(benchmark::State& State, Distribution D) {
+    auto m = make_map<Map>(make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1));
+    for (auto _ : State) {
+        m.rehash(m.bucket_count() * 2);
+        m.rehash(0);
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0) * 2);
+}
+
+// Returns keys of a map merged into a map of keys Keys: every other key of Keys and as many new keys.
+template<class Key>
+std::vector<Key> make_merged_keys(const std::vector<Key>& Keys, Distribution D) {
+    std::vector<Key> Merged = make_keys<Key>(Keys.size() / 2, D, 3);
+    for (size_t i = 0; i < Keys.size(); i += 2) {
+        Merged.push_back(Keys[i]);
+    }
+    std::shuffle(Merged.begin(), Merged.end(), std::mt19937_64(4));
+    return Merged;
+}
+
+// Merges a map of n keys, half of them stored, into a map of n keys with merge(). Building the maps is not timed.
+template<class Map, class Key>
+void merge_benchmark(benchmark::State& State, Distribution D) {
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1);
+    auto Merged = make_merged_keys(Keys, D);
+    for (auto _ : State) {
+        State.PauseTiming();
+        auto m = make_map<Map>(Keys);
+        auto Oth = make_map<Map>(Merged);
+        State.ResumeTiming();
+        m.merge(Oth);
+        benchmark::DoNotOptimize(m);
+        State.PauseTiming();
+        m = Map();
+        Oth = Map();
+        State.ResumeTiming();
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Merges the same maps as merge_benchmark() by inserting items of one map into the other one by one, as a baseline.
+template<class Map, class Key>
+void merge_by_insert_benchmark(benchmark::State& State, Distribution D) {
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1);
+    auto Merged = make_merged_keys(Keys, D);
+    for (auto _ : State) {
+        State.PauseTiming();
+        auto m = make_map<Map>(Keys);
+        auto Oth = make_map<Map>(Merged);
+        State.ResumeTiming();
+        for (auto& Item : Oth) {
+            m.try_emplace(Item.first, std::move(Item.second));
+        }
+        benchmark::DoNotOptimize(m);
+        State.PauseTiming();
+        m = Map();
+        Oth = Map();
+        State.ResumeTiming();
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Erases every item with an odd value, half of a full map, with erase_if(). Building the map is not timed.
+template<class Map, class Key>
+void erase_if_benchmark(benchmark::State& State, Distribution D) {
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1);
+    for (auto _ : State) {
+        State.PauseTiming();
+        auto m = make_map<Map>(Keys);
+        State.ResumeTiming();
+        m.erase_if([](const auto& Item) { return Item.second % 2 != 0; });
+        benchmark::DoNotOptimize(m);
+        State.PauseTiming();
+        m = Map();
+        State.ResumeTiming();
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Erases the same items as erase_if_benchmark() by key one by one, as a baseline.
+template<class Map, class Key>
+void erase_if_by_key_benchmark(benchmark::State& State, Distribution D) {
+    auto Keys = make_keys<Key>(static_cast<size_t>(State.range(0)), D, 1);
+    for (auto _ : State) {
+        State.PauseTiming();
+        auto m = make_map<Map>(Keys);
+        State.ResumeTiming();
+        for (size_t i = 1; i < Keys.size(); i += 2) {
+            m.erase(Keys[i]);
+        }
+        benchmark::DoNotOptimize(m);
+        State.PauseTiming();
+        m = Map();
+        State.ResumeTiming();
+    }
+    State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Map shared by threads of a concurrent benchmark, made by its first thread.
+template<class Map>
+std::unique_ptr<Map> SharedMap;
+
+// Every thread runs operations on a map of n keys: ReadPercent percent lookups of stored keys, the rest
+// assignments to random keys of twice as many, half of which are absent at first.
+template<class Map>
+void concurrent_benchmark(benchmark::State& State) {
+    size_t n = static_cast<size_t>(State.range(0));
+    int64_t ReadPercent = State.range(1);
+    if (State.thread_index() == 0) {
+        SharedMap<Map> = std::make_unique<Map>();
+        for (size_t i = 0; i != n; ++i) {
+            SharedMap<Map>->insert_or_assign(make_key<uint64_t>(i, Distribution::Random, 1), 0);
+        }
+    }
+    std::mt19937_64 Random(static_cast<uint64_t>(State.thread_index()) + 1);
+    for (auto _ : State) {
+        uint64_t r = Random();
+        size_t i = static_cast<size_t>(r % (2 * n));
+        if (static_cast<int64_t>(r >> 32) % 100 < ReadPercent) {
+            benchmark::DoNotOptimize(SharedMap<Map>->contains(make_key<uint64_t>(i / 2, Distribution::Random, 1)));
+        } else {
+            SharedMap<Map>->insert_or_assign(make_key<uint64_t>(i, Distribution::Random, 1), static_cast<int64_t>(r));
+        }
+    }
+    State.SetItemsProcessed(State.iterations());
+    if (State.thread_index() == 0) {
+        SharedMap<Map>.reset();
+    }
+}
+
+// Returns name of key type for benchmark names.
+template<class Key>
+const char* key_name() {
+    return std::is_same<Key, std::string>::value ? "string" : "uint64";
+}
+
+// Type of single-threaded benchmarks of one operation with keys of distribution Distribution.
+typedef void (*OperationBenchmark)(benchmark::State&, Distribution);
+
+// Registers benchmarks of operations Benchmarks of a map named Name with keys of type Key for both distributions
+// and sizes from 1000 to the largest one, growing ten times.
+template<class Key, size_t N>
+void register_operations(const std::string& Name, const std::pair<const char*, OperationBenchmark> (&Benchmarks)[N]) {
+    size_t MaxSize = std::is_same<Key, std::string>::value ? std::min<size_t>(HASH_MAP_BENCHMARK_MAX_SIZE, MaxStringSize)
+                                                           : HASH_MAP_BENCHMARK_MAX_SIZE;
+    for (auto& [Operation, Function] : Benchmarks) {
+        for (Distribution D : {Distribution::Random, Distribution::Adversarial}) {
+            std::string FullName = std::string(Operation) + "/" + Name + "/" + key_name<Key>() + "/" +
+                                   (D == Distribution::Random ? "random" : "adversarial");
+            auto* b = benchmark::RegisterBenchmark(FullName.c_str(), Function, D);
+            for (size_t n = 1000; n <= MaxSize; n *= 10) {
+                b->Arg(static_cast<int64_t>(n));
+            }
+            b->Unit(benchmark::kMillisecond);
+        }
+    }
+}
+
+// Registers every single-threaded benchmark of Map with keys of type Key.
+template<class Map, class Key>
+void register_map(const std::string& Name) {
+    static const std::pair<const char*, OperationBenchmark> Benchmarks[] = {
+        {"insert", insert_benchmark<Map, Key>},   {"find_hit", find_hit_benchmark<Map, Key>}, {"find_miss", find_miss_benchmark<Map, Key>},
+        {"erase", erase_benchmark<Map, Key>},     {"iterate", iterate_benchmark<Map, Key>},   {"rehash", rehash_benchmark<Map, Key>},
+    };
+    register_operations<Key>(Name, Benchmarks);
+}
+
+// Registers benchmarks of bulk operations merge() and erase_if() of Map with keys of type Key next to loops over single
+// items doing the same.
+template<class Map, class Key>
+void register_bulk_operations(const std::string& Name) {
+    static const std::pair<const char*, OperationBenchmark> Benchmarks[] = {
+        {"merge", merge_benchmark<Map, Key>},
+        {"merge_by_insert", merge_by_insert_benchmark<Map, Key>},
+        {"erase_if", erase_if_benchmark<Map, Key>},
+        {"erase_if_by_key", erase_if_by_key_benchmark<Map, Key>},
+    };
+    register_operations<Key>(Name, Benchmarks);
+}
+
+// Registers lookup and iteration benchmarks of Map with keys of type Key, for maps which differ from others only in memory.
+template<class Map, class Key>
+void register_memory_benchmarks(const std::string& Name) {
+    static const std::pair<const char*, OperationBenchmark> Benchmarks[] = {
+        {"find_hit", find_hit_benchmark<Map, Key>},
+        {"iterate", iterate_benchmark<Map, Key>},
+    };
+    register_operations<Key>(Name, Benchmarks);
+}
+
+// Registers concurrent benchmarks of Map for 1, 2, 4 and 8 threads with 50, 90 and 100 percent of reads.
+template<class Map>
+void register_concurrent_map(const std::string& Name) {
+    auto* b = benchmark::RegisterBenchmark(("mixed/" + Name + "/uint64/random").c_str(), concurrent_benchmark<Map>);
+    for (size_t n = 1000; n <= std::min<size_t>(HASH_MAP_BENCHMARK_MAX_SIZE, MaxConcurrentSize); n *= 10) {
+        for (int64_t ReadPercent : {50, 90, 100}) {
+            b->Args({static_cast<int64_t>(n), ReadPercent});
+        }
+    }
+    b->ArgNames({"size", "read%"})->ThreadRange(1, 8)->UseRealTime();
+}
+
+template<class Key>
+void register_maps() {
+    register_map<HashMap<Key, int64_t>, Key>("HashMap");
+    register_map<FlatHashMap<Key, int64_t>, Key>("FlatHashMap");
+    register_map<std::unordered_map<Key, int64_t>, Key>("std::unordered_map");
+#ifdef HASH_MAP_BENCHMARK_ABSL
+    register_map<absl::flat_hash_map<Key, int64_t>, Key>("absl::flat_hash_map");
+#endif
+    register_bulk_operations<HashMap<Key, int64_t>, Key>("HashMap");
+}
+
+#ifdef HASH_MAP_MMAP
+// Registers lookup and iteration benchmarks of HashMap and FlatHashMap with memory of PageResource with huge pages Pages.
+template<HugePages Pages>
+void register_page_maps(const std::string& PagesName) {
+    typedef BenchmarkPageAllocator<std::pair<const uint64_t, int64_t>, Pages> Allocator;
+    register_memory_benchmarks<HashMap<uint64_t, int64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PrimeGrowthPolicy, Allocator>, uint64_t>(
+        "HashMap+pages:" + PagesName);
+    register_memory_benchmarks<FlatHashMap<uint64_t, int64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, Allocator>, uint64_t>(
+        "FlatHashMap+pages:" + PagesName);
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+    register_maps<uint64_t>();
+    register_map<IntHashMap<uint64_t, int64_t>, uint64_t>("IntHashMap");
+#ifdef HASH_MAP_MMAP
+    register_page_maps<HugePages::None>("none");
+    register_page_maps<HugePages::Transparent>("transparent");
+#endif
+    register_maps<std::string>();
+    register_concurrent_map<ConcurrentHashMap<uint64_t, int64_t>>("ConcurrentHashMap");
+    register_concurrent_map<LockFreeReadHashMap<uint64_t, int64_t>>("LockFreeReadHashMap");
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,361 +1,7028 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <scoped_allocator>
+#include <shared_mutex>
 #include <stdexcept>
+#include <string>
+#include <system_error>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
+#if defined(__SSE2__) && !defined(HASH_MAP_NO_SIMD)
+#include <immintrin.h>
+#endif
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(HASH_MAP_NO_MMAP)
+#define HASH_MAP_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
 
-template<class ValueType> class HashMapIterator;
-template<class ValueType> class HashMapConstIterator;
+template<class TableType, class BitmapType> class HashMapIterator;
+template<class TableType, class BitmapType> class HashMapConstIterator;
+template<class SlotType, class MapIterator> class SmallHashMapIterator;
+template<class SlotType, class MapIterator> class SmallHashMapConstIterator;
+template<class SlotType> class FlatHashMapIterator;
+template<class SlotType> class FlatHashMapConstIterator;
+template<class EntryType> class OrderedHashMapIterator;
+template<class EntryType> class OrderedHashMapConstIterator;
+template<class KeyType, class ValueType> class IntHashMapIterator;
+template<class KeyType, class ValueType> class IntHashMapConstIterator;
+template<class MapType> class ConcurrentHashMapSnapshotIterator;
+template<class NodeType> class LockFreeReadHashMapSnapshotIterator;
+
+// Returns number of trailing zero bits of nonzero x in O(1) time.
+inline size_t count_trailing_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    size_t n = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// Returns number of the first set bit of bitmap Bits of n bits not less than i, or n if there is none.
+// Works in O(distance / 64) time.
+inline size_t find_next_set_bit(const uint64_t* Bits, size_t n, size_t i) {
+    if (i >= n) {
+        return n;
+    }
+    size_t w = i / 64;
+    uint64_t Word = Bits[w] & (~uint64_t(0) << (i % 64));
+    while (Word == 0) {
+        if (++w * 64 >= n) {
+            return n;
+        }
+        Word = Bits[w];
+    }
+    return std::min(n, w * 64 + count_trailing_zeros(Word));
+}
+
+// Hints the processor to load the cache line of p for reading. Does nothing where the hint is not available.
+inline void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 0, 3);
+#else
+    (void)p;
+#endif
+}
+
+// Returns the greatest power of two not exceeding nonzero x in O(1) time.
+inline size_t highest_power_of_two(size_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(1) << (63 - __builtin_clzll(x));
+#else
+    size_t p = 1;
+    while (x >>= 1) {
+        p <<= 1;
+    }
+    return p;
+#endif
+}
+
+#ifdef __SIZEOF_INT128__
+// 128-bit unsigned integer of GCC and Clang; __extension__ keeps -Wpedantic quiet in files including the maps.
+__extension__ typedef unsigned __int128 uint128_type;
+#endif
+
+// Returns number in [0, n) taken from high bits of well-mixed x in O(1) time: the high 64 bits of the 128-bit product x * n.
+// Without 128-bit integers the product is assembled from 32-bit halves, so positions, and files of FrozenHashMap which
+// depend on them, are the same on every compiler.
+inline size_t reduce_range(uint64_t x, size_t n) {
+#ifdef __SIZEOF_INT128__
+    return static_cast<size_t>((static_cast<uint128_type>(x) * n) >> 64);
+#else
+    uint64_t y = n;
+    uint64_t Low = (x & 0xffffffffu) * (y & 0xffffffffu);
+    uint64_t Cross1 = (x >> 32) * (y & 0xffffffffu);
+    uint64_t Cross2 = (x & 0xffffffffu) * (y >> 32);
+    uint64_t Middle = (Low >> 32) + (Cross1 & 0xffffffffu) + (Cross2 & 0xffffffffu);
+    return static_cast<size_t>((x >> 32) * (y >> 32) + (Cross1 >> 32) + (Cross2 >> 32) + (Middle >> 32));
+#endif
+}
+
+// Hash mixer applying 64-bit finalizer of MurmurHash3, so that every bit of the result depends on every bit of the hash.
+// Needed when table index takes only low bits of the hash: std::hash of integers is often the identity function.
+struct MurmurHashMixer {
+    // Returns mixed hash h in O(1) time.
+    constexpr size_t operator()(size_t h) const {
+        uint64_t x = static_cast<uint64_t>(h);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+};
+
+// Hash mixer multiplying the hash by 2^64 divided by golden ratio and folding high half of the product into low half.
+// Cheaper than MurmurHashMixer, good enough for sequential and strided keys.
+struct FibonacciHashMixer {
+    // Returns mixed hash h in O(1) time.
+    constexpr size_t operator()(size_t h) const {
+        uint64_t x = static_cast<uint64_t>(h) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(x ^ (x >> 32));
+    }
+};
+
+// Hash mixer returning the hash as is. For hash functions which already mix well.
+struct IdentityHashMixer {
+    // Returns h in O(1) time.
+    constexpr size_t operator()(size_t h) const {
+        return h;
+    }
+};
+
+// Growth policy keeping bucket count a prime number, so that modulo indexing uses all bits of the hash.
+// Table grows by ResizeFactor when it becomes dense and shrinks when its load factor drops below
+// ShrinkFactor * max_load_factor(). The gap between the two bounds keeps erase and insert from resizing back and forth.
+struct PrimeGrowthPolicy {
+    static constexpr bool Incremental = false;
+    static constexpr size_t ResizeFactor = 2;
+    static constexpr float ShrinkFactor = 0.25f;
+    // Returns the smallest supported bucket count not less than n in O(log) time.
+    size_t bucket_count(size_t n) const {
+        static constexpr unsigned long long Primes[] = {
+        1ULL, 2ULL, 5ULL, 11ULL, 17ULL, 37ULL, 67ULL, 131ULL, 257ULL, 521ULL, 1031ULL, 2053ULL, 4099ULL, 8209ULL,
+        16411ULL, 32771ULL, 65537ULL, 131101ULL, 262147ULL, 524309ULL, 1048583ULL, 2097169ULL, 4194319ULL, 8388617ULL,
+        16777259ULL, 33554467ULL, 67108879ULL, 134217757ULL, 268435459ULL, 536870923ULL, 1073741827ULL, 2147483659ULL,
+        4294967311ULL, 8589934609ULL, 17179869209ULL, 34359738421ULL, 68719476767ULL, 137438953481ULL, 274877906951ULL,
+        549755813911ULL, 1099511627791ULL, 2199023255579ULL, 4398046511119ULL, 8796093022237ULL, 17592186044423ULL,
+        35184372088891ULL, 70368744177679ULL, 140737488355333ULL, 281474976710677ULL, 562949953421381ULL,
+        1125899906842679ULL, 2251799813685269ULL, 4503599627370517ULL, 9007199254740997ULL, 18014398509482143ULL,
+        36028797018963971ULL, 72057594037928017ULL, 144115188075855881ULL, 288230376151711813ULL, 576460752303423619ULL,
+        1152921504606847009ULL, 2305843009213693967ULL, 4611686018427388039ULL, 9223372036854775837ULL
+        };
+        auto p = std::lower_bound(std::begin(Primes), std::end(Primes), static_cast<unsigned long long>(n));
+        return p == std::end(Primes) ? n : static_cast<size_t>(*p);
+    }
+    // Returns bucket number of hash h in table of n buckets in O(1) time.
+    size_t index(size_t h, size_t n) const {
+        return h % n;
+    }
+};
+
+// Growth policy keeping bucket count a power of two, so that bucket number is taken by a bit mask instead of division.
+// Hash is passed through Mixer first, otherwise hashes differing only in high bits would share a bucket.
+// Table grows by ResizeFactor when it becomes dense and shrinks when its load factor drops below
+// ShrinkFactor * max_load_factor().
+template<class Mixer = MurmurHashMixer>
+struct PowerOfTwoGrowthPolicy {
+    static constexpr bool Incremental = false;
+    static constexpr size_t ResizeFactor = 2;
+    static constexpr float ShrinkFactor = 0.25f;
+    // Returns the smallest power of two not less than n in O(log n) time.
+    size_t bucket_count(size_t n) const {
+        size_t c = 1;
+        while (c < n) {
+            c <<= 1;
+        }
+        return c;
+    }
+    // Returns bucket number of hash h in table of n buckets in O(1) time. n must be a power of two.
+    size_t index(size_t h, size_t n) const {
+        return Mix(h) & (n - 1);
+    }
+    Mixer Mix;
+};
+
+// Growth policy of linear hashing: table grows and shrinks by one bucket at a time, so rehashing is spread over inserts
+// and erases and none of them moves more than a few buckets. Bucket count may be any positive number.
+// With m the greatest power of two not exceeding bucket count n, bucket number is the hash modulo 2m, or modulo m if the
+// former is not less than n. Adding bucket n therefore only splits bucket n - m, and removing it merges them back.
+// Explicit rehash() and reserve() still rebuild the whole table at once.
+// https://en.wikipedia.org/wiki/Linear_hashing
+template<class Mixer = MurmurHashMixer>
+struct LinearGrowthPolicy {
+    static constexpr bool Incremental = true;
+    static constexpr size_t ResizeFactor = 2;
+    static constexpr float ShrinkFactor = 0.25f;
+    // Returns n, or 1 if n is zero, in O(1) time.
+    size_t bucket_count(size_t n) const {
+        return std::max<size_t>(n, 1);
+    }
+    // Returns bucket number of hash h in table of n buckets in O(1) time.
+    size_t index(size_t h, size_t n) const {
+        size_t m = highest_power_of_two(n);
+        size_t i = Mix(h) & (2 * m - 1);
+        return i < n ? i : i - m;
+    }
+    Mixer Mix;
+};
+
+// True if Hash and KeyEqual both declare is_transparent, so maps may look up keys of other types without converting them.
+template<class Hash, class KeyEqual, class = void>
+struct IsTransparentLookup: std::false_type {};
+template<class Hash, class KeyEqual>
+struct IsTransparentLookup<Hash, KeyEqual, std::void_t<typename Hash::is_transparent, typename KeyEqual::is_transparent>>: std::true_type {};
+
+// Transparent string hash: std::string, std::string_view and C strings with equal contents get equal hashes.
+// Together with std::equal_to<> lets maps with std::string keys be searched by std::string_view without allocation.
+struct TransparentStringHash {
+    typedef void is_transparent;
+    // Returns hash of string s in O(length) time.
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>()(s);
+    }
+};
+
+// Returns a new random seed in O(1) time: a process-wide random value, taken once from std::random_device,
+// mixed with the number of the calling thread and a counter of the thread. Different calls return different seeds,
+// which are unpredictable outside the process. Only the first call of every thread touches shared state, so
+// maps constructed in many threads at once do not contend on a shared counter.
+inline size_t hash_map_random_seed() {
+    static const uint64_t ProcessSeed = [] {
+        uint64_t x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&ProcessSeed));
+        try {
+            std::random_device Device;
+            x ^= static_cast<uint64_t>(Device()) << 32 ^ Device();
+        } catch (const std::exception&) {
+        }
+        return x;
+    }();
+    static std::atomic<uint64_t> ThreadCount(0);
+    thread_local uint64_t Counter = ThreadCount.fetch_add(1, std::memory_order_relaxed) << 40;
+    return MurmurHashMixer()(ProcessSeed + Counter++ * 0x9e3779b97f4a7c15ULL);
+}
+
+// Keyed hash function SipHash-1-3 of 128-bit key: without the key, finding keys with equal hashes is infeasible,
+// so hash flooding does not work. About twice as slow as std::hash of strings. Transparent: hashes integers and
+// enumerations by value and anything convertible to std::string_view by contents.
+// https://en.wikipedia.org/wiki/SipHash
+class SipHash {
+  public:
+    typedef void is_transparent;
+    // Constructor with random key.
+    SipHash(): SipHash(hash_map_random_seed(), hash_map_random_seed()) {}
+    // Constructor with key K0, K1.
+    SipHash(uint64_t K0, uint64_t K1): K0(K0), K1(K1) {}
+    // Returns hash of string s in O(length) time.
+    size_t operator()(std::string_view s) const {
+        return hash(s.data(), s.size());
+    }
+    // Returns hash of integer or enumeration x in O(1) time. Equal values of different types get equal hashes.
+    template<class T, class = typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+    size_t operator()(T x) const {
+        unsigned char Bytes[8];
+        uint64_t Value = static_cast<uint64_t>(x);
+        std::memcpy(Bytes, &Value, sizeof(Value));
+        return hash(Bytes, sizeof(Bytes));
+    }
+    // Returns hash of n bytes at Data in O(n) time.
+    size_t hash(const void* Data, size_t n) const {
+        const unsigned char* p = static_cast<const unsigned char*>(Data);
+        uint64_t v0 = K0 ^ 0x736f6d6570736575ULL, v1 = K1 ^ 0x646f72616e646f6dULL;
+        uint64_t v2 = K0 ^ 0x6c7967656e657261ULL, v3 = K1 ^ 0x7465646279746573ULL;
+        auto Round = [&] {
+            v0 += v1;
+            v1 = rotate(v1, 13) ^ v0;
+            v0 = rotate(v0, 32);
+            v2 += v3;
+            v3 = rotate(v3, 16) ^ v2;
+            v0 += v3;
+            v3 = rotate(v3, 21) ^ v0;
+            v2 += v1;
+            v1 = rotate(v1, 17) ^ v2;
+            v2 = rotate(v2, 32);
+        };
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t m;
+            std::memcpy(&m, p + i, sizeof(m));
+            v3 ^= m;
+            Round();
+            v0 ^= m;
+        }
+        uint64_t m = load(p + i, n - i) | static_cast<uint64_t>(n) << 56;
+        v3 ^= m;
+        Round();
+        v0 ^= m;
+        v2 ^= 0xff;
+        Round();
+        Round();
+        Round();
+        return static_cast<size_t>(v0 ^ v1 ^ v2 ^ v3);
+    }
+
+  private:
+    // Returns x rotated left by r bits.
+    static uint64_t rotate(uint64_t x, int r) {
+        return x << r | x >> (64 - r);
+    }
+    // Returns little-endian number of n < 8 bytes at p.
+    static uint64_t load(const unsigned char* p, size_t n) {
+        uint64_t x = 0;
+        for (size_t i = 0; i != n; ++i) {
+            x |= static_cast<uint64_t>(p[i]) << (8 * i);
+        }
+        return x;
+    }
+    uint64_t K0;
+    uint64_t K1;
+};
+
+// True if SipHash hashes keys of type K consistently with std::equal_to.
+template<class K>
+struct IsSipHashable: std::integral_constant<bool, std::is_integral<K>::value || std::is_enum<K>::value || std::is_convertible<const K&, std::string_view>::value> {};
+
+// Monotonic memory arena: hands out memory by bumping a pointer inside chunks taken from the global heap and frees
+// all of it at once on release() or destruction. Deallocating a single block does nothing.
+// Chunk sizes start at ChunkSize and double up to MaxChunkSize, so a map growing in the arena takes O(log) chunks.
+// Not thread safe: meant for maps built and dropped together, e.g. per request or per thread, to stay off the global heap.
+class MonotonicArena {
+  public:
+    static constexpr bool ThreadSafe = false;
+    static constexpr size_t DefaultChunkSize = 4096;
+    static constexpr size_t MaxChunkSize = 1 << 20;
+    // Constructor with size of the first chunk. Does not allocate.
+    explicit MonotonicArena(size_t ChunkSize = DefaultChunkSize): NextChunkSize(std::max(ChunkSize, 2 * sizeof(Chunk))) {}
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+    // Frees every chunk in O(chunks) time.
+    ~MonotonicArena() {
+        release();
+    }
+    // Returns n bytes aligned by power of two Align in O(1) amortized time.
+    void* allocate(size_t n, size_t Align) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(Current) + Align - 1) & ~static_cast<uintptr_t>(Align - 1);
+        if (Current == nullptr || p + n > reinterpret_cast<uintptr_t>(End)) {
+            add_chunk(n + Align);
+            p = (reinterpret_cast<uintptr_t>(Current) + Align - 1) & ~static_cast<uintptr_t>(Align - 1);
+        }
+        Current = reinterpret_cast<char*>(p + n);
+        return reinterpret_cast<void*>(p);
+    }
+    // Does nothing: memory is only freed by release() or destruction.
+    void deallocate(void*, size_t, size_t) noexcept {}
+    // Frees every chunk in O(chunks) time. Memory handed out before becomes invalid.
+    void release() noexcept {
+        while (Chunks != nullptr) {
+            Chunk* Next = Chunks->Next;
+            ::operator delete(static_cast<void*>(Chunks));
+            Chunks = Next;
+        }
+        Current = End = nullptr;
+    }
+  private:
+    // Header of a chunk, followed by its memory.
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* Next;
+    };
+    // Takes from the global heap a chunk of at least n bytes after the header in O(1) time.
+    void add_chunk(size_t n) {
+        size_t Size = std::max(NextChunkSize, n + sizeof(Chunk));
+        Chunk* New = static_cast<Chunk*>(::operator new(Size));
+        New->Next = Chunks;
+        Chunks = New;
+        Current = reinterpret_cast<char*>(New) + sizeof(Chunk);
+        End = reinterpret_cast<char*>(New) + Size;
+        if (NextChunkSize < MaxChunkSize) {
+            NextChunkSize *= 2;
+        }
+    }
+    Chunk* Chunks = nullptr;
+    char* Current = nullptr;
+    char* End = nullptr;
+    size_t NextChunkSize;
+};
+
+// Pool of fixed-size blocks on top of MonotonicArena. Blocks come in size classes of powers of two from MinBlockSize to
+// MaxBlockSize, and each class keeps a free list, so allocation and deallocation take O(1) time and freed blocks are reused.
+// Fits HashMap buckets: bucket arrays grow by doubling, so their sizes repeat the same few classes over and over.
+// Larger blocks, such as the bucket table itself or FlatHashMap slots, go to the global heap directly.
+// All pooled memory is freed at once on destruction. Not thread safe.
+class FixedSizePool {
+  public:
+    static constexpr bool ThreadSafe = false;
+    static constexpr size_t MinBlockSize = 16;
+    static constexpr size_t MaxBlockSize = 1024;
+    // Constructor with size of the first arena chunk. Does not allocate.
+    explicit FixedSizePool(size_t ChunkSize = 16 * MonotonicArena::DefaultChunkSize): Arena(ChunkSize) {}
+    FixedSizePool(const FixedSizePool&) = delete;
+    FixedSizePool& operator=(const FixedSizePool&) = delete;
+    // Returns n bytes aligned by power of two Align in O(1) amortized time.
+    void* allocate(size_t n, size_t Align) {
+        if (n > MaxBlockSize || Align > alignof(std::max_align_t)) {
+            return ::operator new(n, std::align_val_t(Align));
+        }
+        size_t c = size_class(n);
+        if (FreeLists[c] != nullptr) {
+            Block* b = FreeLists[c];
+            FreeLists[c] = b->Next;
+            return b;
+        }
+        return Arena.allocate(MinBlockSize << c, alignof(std::max_align_t));
+    }
+    // Returns block p of n bytes aligned by Align to its free list in O(1) time.
+    void deallocate(void* p, size_t n, size_t Align) noexcept {
+        if (n > MaxBlockSize || Align > alignof(std::max_align_t)) {
+            ::operator delete(p, std::align_val_t(Align));
+            return;
+        }
+        size_t c = size_class(n);
+        Block* b = static_cast<Block*>(p);
+        b->Next = FreeLists[c];
+        FreeLists[c] = b;
+    }
+  private:
+    // Free block, linked into the free list of its class.
+    struct Block {
+        Block* Next;
+    };
+    static constexpr size_t ClassCount = 7;
+    // Returns number of the smallest size class fitting n bytes in O(1) time.
+    static size_t size_class(size_t n) {
+        return n <= MinBlockSize ? 0 : count_trailing_zeros(highest_power_of_two(n - 1)) + 1 - count_trailing_zeros(MinBlockSize);
+    }
+    MonotonicArena Arena;
+    Block* FreeLists[ClassCount] = {};
+};
+
+// Stateful allocator handing out memory of Resource, such as MonotonicArena or FixedSizePool.
+// Copies and rebound copies share the resource and compare equal if and only if they use the same one.
+// Resource must outlive every map using the allocator. Copies may be used by several threads at once only if
+// Resource::ThreadSafe is true.
+template<class T, class Resource>
+class ResourceAllocator {
+  public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    // Constructor by resource.
+    ResourceAllocator(Resource& r) noexcept: Res(&r) {}
+    // Constructor from allocator of another type sharing the resource.
+    template<class U>
+    ResourceAllocator(const ResourceAllocator<U, Resource>& Oth) noexcept: Res(Oth.resource()) {}
+    // Returns memory for n objects in O(1) amortized time.
+    T* allocate(size_t n) {
+        return static_cast<T*>(Res->allocate(n * sizeof(T), alignof(T)));
+    }
+    // Returns memory of n objects to the resource in O(1) time.
+    void deallocate(T* p, size_t n) noexcept {
+        Res->deallocate(p, n * sizeof(T), alignof(T));
+    }
+    // Returns the resource in O(1) time.
+    Resource* resource() const noexcept {
+        return Res;
+    }
+    // Returns true if allocators share the resource in O(1) time.
+    template<class U>
+    bool operator==(const ResourceAllocator<U, Resource>& Oth) const noexcept {
+        return Res == Oth.resource();
+    }
+    // Returns true if allocators use different resources in O(1) time.
+    template<class U>
+    bool operator!=(const ResourceAllocator<U, Resource>& Oth) const noexcept {
+        return Res != Oth.resource();
+    }
+  private:
+    Resource* Res;
+};
+
+// Allocator of MonotonicArena memory: a map using it is freed in one shot with the arena.
+template<class T>
+using ArenaAllocator = ResourceAllocator<T, MonotonicArena>;
+// Allocator of FixedSizePool memory: reuses freed bucket arrays without going to the global heap.
+template<class T>
+using PoolAllocator = ResourceAllocator<T, FixedSizePool>;
+
+// True if copies of allocator A may allocate and deallocate on several threads at once: if A is stateless
+// or uses a thread safe resource. Other allocators, such as ArenaAllocator, need a resource per thread.
+template<class A>
+struct IsThreadSafeAllocator: std::allocator_traits<A>::is_always_equal {};
+template<class T, class Resource>
+struct IsThreadSafeAllocator<ResourceAllocator<T, Resource>>: std::integral_constant<bool, Resource::ThreadSafe> {};
+
+#ifdef HASH_MAP_MMAP
+// Huge pages used by PageResource: none, transparent huge pages requested by madvise(), or explicit huge pages from
+// the pool reserved by the system administrator, falling back to transparent ones when the pool is empty.
+enum class HugePages { None, Transparent, Explicit };
+// NUMA placement of PageResource memory: on the node of the thread touching a page first, interleaved over all online
+// nodes page by page, or preferably on one node.
+enum class NumaPlacement { FirstTouch, Interleave, Node };
+
+// Memory resource of anonymous page mappings with huge page and NUMA placement policy, for ResourceAllocator.
+// Blocks of at least HugePageSize get mappings of their own, aligned and rounded up to huge pages; the bucket table of
+// a large HashMap or the slot array of a large FlatHashMap is such a block. Blocks up to MaxBlockSize aligned by at most
+// MaxBlockAlign, such as HashMap buckets, are carved from huge page chunks and reused through free lists of power of
+// two size classes, like in FixedSizePool. Other blocks get mappings of whole pages. Every mapping is placed by the NUMA policy before its pages
+// are touched. Placement the kernel can not honor, for example without NUMA support, is skipped, since it only
+// affects speed. Thread safe, so shards of a concurrent map may share it. Chunks are unmapped on destruction.
+class PageResource {
+  public:
+    static constexpr bool ThreadSafe = true;
+    static constexpr size_t HugePageSize = 2 << 20;
+    static constexpr size_t MinBlockSize = 16;
+    static constexpr size_t MaxBlockSize = 4096;
+    static constexpr size_t MaxBlockAlign = 64;
+    // Constructor with huge page use, NUMA placement and node for NumaPlacement::Node. Does not allocate.
+    // If the node number is not less than 64, throws invalid argument exception.
+    explicit PageResource(HugePages Pages = HugePages::Transparent, NumaPlacement Placement = NumaPlacement::FirstTouch, size_t Node = 0)
+        : Pages(Pages), Placement(Placement), Node(Node) {
+        if (Node >= 64) {
+            throw std::invalid_argument("incorrect node");
+        }
+    }
+    PageResource(const PageResource&) = delete;
+    PageResource& operator=(const PageResource&) = delete;
+    // Unmaps every chunk in O(chunks) time.
+    ~PageResource() {
+        for (void* c : Chunks) {
+            ::munmap(c, HugePageSize);
+        }
+    }
+    // Returns n bytes aligned by power of two Align, at most the page size, in O(1) amortized time for small blocks
+    // and one system call for others. Throws bad alloc exception if the memory can not be mapped.
+    void* allocate(size_t n, size_t Align) {
+        if (std::max(n, Align) > MaxBlockSize || Align > MaxBlockAlign) {
+            return map(mapping_size(n));
+        }
+        size_t c = size_class(std::max(n, Align));
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (FreeLists[c] != nullptr) {
+            Block* b = FreeLists[c];
+            FreeLists[c] = b->Next;
+            return b;
+        }
+        size_t Size = MinBlockSize << c;
+        // Every block is aligned by its size up to MaxBlockAlign, so that freed blocks fit any request of their class.
+        uintptr_t a = std::min(Size, MaxBlockAlign);
+        uintptr_t p = (reinterpret_cast<uintptr_t>(ChunkCurrent) + a - 1) & ~(a - 1);
+        if (ChunkCurrent == nullptr || p + Size > reinterpret_cast<uintptr_t>(ChunkEnd)) {
+            Chunks.reserve(Chunks.size() + 1);
+            ChunkCurrent = static_cast<char*>(map(HugePageSize));
+            ChunkEnd = ChunkCurrent + HugePageSize;
+            Chunks.push_back(ChunkCurrent);
+            p = reinterpret_cast<uintptr_t>(ChunkCurrent);
+        }
+        ChunkCurrent = reinterpret_cast<char*>(p + Size);
+        return reinterpret_cast<void*>(p);
+    }
+    // Returns block p of n bytes aligned by Align to its free list in O(1) time or unmaps it.
+    void deallocate(void* p, size_t n, size_t Align) noexcept {
+        if (std::max(n, Align) > MaxBlockSize || Align > MaxBlockAlign) {
+            size_t Size = mapping_size(n);
+            ::munmap(p, Size);
+            MappedBytes.fetch_sub(Size, std::memory_order_relaxed);
+            return;
+        }
+        size_t c = size_class(std::max(n, Align));
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Block* b = static_cast<Block*>(p);
+        b->Next = FreeLists[c];
+        FreeLists[c] = b;
+    }
+    // Returns number of mapped bytes, including free blocks of chunks, in O(1) time.
+    size_t mapped_bytes() const {
+        return MappedBytes.load(std::memory_order_relaxed);
+    }
+    // Returns numbers of online NUMA nodes in increasing order in O(nodes) time, or node 0 if they are unknown.
+    // Shards of a concurrent map can take PageResource objects of different nodes, see ConcurrentHashMap.
+    static std::vector<size_t> numa_nodes() {
+        std::vector<size_t> Nodes;
+        if (FILE* f = std::fopen("/sys/devices/system/node/online", "r")) {
+            // The file lists ranges of node numbers, such as "0-1,4".
+            unsigned long First, Last;
+            int c = ',';
+            while (c == ',' && std::fscanf(f, "%lu", &First) == 1) {
+                Last = First;
+                c = std::fgetc(f);
+                if (c == '-' && std::fscanf(f, "%lu", &Last) == 1) {
+                    c = std::fgetc(f);
+                }
+                for (unsigned long i = First; i <= Last && Nodes.size() < 1024; ++i) {
+                    Nodes.push_back(i);
+                }
+            }
+            std::fclose(f);
+        }
+        if (Nodes.empty()) {
+            Nodes.push_back(0);
+        }
+        return Nodes;
+    }
+  private:
+    // Free block, linked into the free list of its class.
+    struct Block {
+        Block* Next;
+    };
+    static constexpr size_t ClassCount = 9;
+    // Returns number of the smallest size class fitting n bytes in O(1) time.
+    static size_t size_class(size_t n) {
+        return n <= MinBlockSize ? 0 : count_trailing_zeros(highest_power_of_two(n - 1)) + 1 - count_trailing_zeros(MinBlockSize);
+    }
+    // Returns size of the mapping of a block of n bytes: whole huge pages if they are used and the block fits at least
+    // one, whole pages otherwise. Works in O(1) time.
+    size_t mapping_size(size_t n) const {
+        static const size_t PageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t Unit = Pages != HugePages::None && n >= HugePageSize ? HugePageSize : PageSize;
+        return (n + Unit - 1) / Unit * Unit;
+    }
+    // Maps Size bytes, a multiple of the page size, by the huge page and NUMA policy. Throws bad alloc exception on failure.
+    void* map(size_t Size) {
+        bool Huge = Pages != HugePages::None && Size % HugePageSize == 0;
+        void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (Huge && Pages == HugePages::Explicit) {
+            p = ::mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+#endif
+        if (p == MAP_FAILED && Huge) {
+            p = map_huge_aligned(Size);
+        }
+        if (p == MAP_FAILED) {
+            p = ::mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        place(p, Size);
+        MappedBytes.fetch_add(Size, std::memory_order_relaxed);
+        return p;
+    }
+    // Maps Size bytes at a huge page boundary, so that transparent huge pages can back all of them, and asks for them.
+    // Returns MAP_FAILED on failure.
+    static void* map_huge_aligned(size_t Size) {
+        void* p = ::mmap(nullptr, Size + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            return p;
+        }
+        char* Begin = static_cast<char*>(p);
+        char* Aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(Begin) + HugePageSize - 1) & ~static_cast<uintptr_t>(HugePageSize - 1));
+        if (Aligned != Begin) {
+            ::munmap(Begin, static_cast<size_t>(Aligned - Begin));
+        }
+        if (Aligned + Size != Begin + Size + HugePageSize) {
+            ::munmap(Aligned + Size, static_cast<size_t>(Begin + HugePageSize - Aligned));
+        }
+#ifdef MADV_HUGEPAGE
+        ::madvise(Aligned, Size, MADV_HUGEPAGE);
+#endif
+        return Aligned;
+    }
+    // Applies NUMA placement to Size bytes mapped at p, whose pages are not touched yet. Failures are ignored.
+    void place([[maybe_unused]] void* p, [[maybe_unused]] size_t Size) const {
+#if defined(__linux__) && defined(SYS_mbind)
+        // Modes of mbind() from <numaif.h>, which is not always installed.
+        constexpr int PreferredMode = 1, InterleaveMode = 3;
+        if (Placement == NumaPlacement::FirstTouch) {
+            return;
+        }
+        unsigned long Mask = 0;
+        if (Placement == NumaPlacement::Node) {
+            Mask = 1UL << Node;
+        } else {
+            static const unsigned long Online = [] {
+                unsigned long m = 0;
+                for (size_t i : numa_nodes()) {
+                    m |= i < 64 ? 1UL << i : 0;
+                }
+                return m;
+            }();
+            Mask = Online;
+        }
+        // The kernel reads one bit less than the given number of bits.
+        ::syscall(SYS_mbind, p, Size, Placement == NumaPlacement::Node ? PreferredMode : InterleaveMode, &Mask, sizeof(Mask) * 8 + 1, 0);
+#endif
+    }
+    HugePages Pages;
+    NumaPlacement Placement;
+    size_t Node;
+    std::mutex Mutex;
+    Block* FreeLists[ClassCount] = {};
+    std::vector<void*> Chunks;
+    char* ChunkCurrent = nullptr;
+    char* ChunkEnd = nullptr;
+    std::atomic<size_t> MappedBytes{0};
+};
+
+// Allocator of PageResource memory: huge pages and NUMA placement for large maps.
+template<class T>
+using PageAllocator = ResourceAllocator<T, PageResource>;
+#endif
+
+// Full hash of an item, kept next to it by HashMapSlot if StoreHash is true. Empty otherwise.
+// A stored hash saves rehashing keys when the table resizes and rejects most unequal keys without comparing them.
+template<bool StoreHash>
+struct HashMapSlotHash {
+    static constexpr bool Stored = false;
+    // Does nothing: the hash is not stored.
+    void set_hash(size_t) {}
+    // Returns true: without stored hash only keys tell items apart.
+    bool hash_matches(size_t) const {
+        return true;
+    }
+};
+
+// Full hash of an item stored next to it.
+template<>
+struct HashMapSlotHash<true> {
+    static constexpr bool Stored = true;
+    // Stores hash h in O(1) time.
+    void set_hash(size_t h) {
+        Hash = h;
+    }
+    // Returns stored hash in O(1) time.
+    size_t hash() const {
+        return Hash;
+    }
+    // Returns true if stored hash equals h in O(1) time.
+    bool hash_matches(size_t h) const {
+        return Hash == h;
+    }
+    size_t Hash = 0;
+};
+
+// Storage of one item in HashMap buckets and FlatHashMap slots, with the full item hash if StoreHash is true.
+// Users see the item as a pair with constant key. The maps move it as a pair with mutable key, so that bucket growth,
+// rehashing and erasing relocate both key and value instead of copying them. Both pairs have the same layout and
+// the mutable one is only used to move out of an item which is destroyed or overwritten right after.
+template<class KeyType, class ValueType, bool StoreHash = false>
+struct HashMapSlot: HashMapSlotHash<StoreHash> {
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef std::pair<KeyType, ValueType> mutable_value_type;
+    // True if items may be relocated by copying their bytes.
+    static constexpr bool TriviallyRelocatable = std::is_trivially_copyable<KeyType>::value && std::is_trivially_copyable<ValueType>::value;
+    // Constructs item from args.
+    template<class... Args>
+    explicit HashMapSlot(std::in_place_t, Args&&... args): Value(std::forward<Args>(args)...) {}
+    // Copy constructor.
+    HashMapSlot(const HashMapSlot& Oth): HashMapSlotHash<StoreHash>(Oth), Value(Oth.Value) {}
+    // Move constructor. Moves both key and value of Oth.
+    HashMapSlot(HashMapSlot&& Oth) noexcept(std::is_nothrow_move_constructible<mutable_value_type>::value)
+        : HashMapSlotHash<StoreHash>(Oth), MutableValue(std::move(Oth.mutable_value())) {}
+    // Copy assignment.
+    HashMapSlot& operator=(const HashMapSlot& Oth) {
+        HashMapSlotHash<StoreHash>::operator=(Oth);
+        mutable_value() = Oth.Value;
+        return *this;
+    }
+    // Move assignment. Moves both key and value of Oth.
+    HashMapSlot& operator=(HashMapSlot&& Oth) noexcept(std::is_nothrow_move_assignable<mutable_value_type>::value) {
+        HashMapSlotHash<StoreHash>::operator=(Oth);
+        mutable_value() = std::move(Oth.mutable_value());
+        return *this;
+    }
+    // Destroys item.
+    ~HashMapSlot() {
+        Value.~value_type();
+    }
+    // Returns item as a pair with mutable key in O(1) time.
+    mutable_value_type& mutable_value() {
+        return *std::launder(&MutableValue);
+    }
+    union {
+        value_type Value;
+        mutable_value_type MutableValue;
+    };
+};
+
+// Runs f(0), ..., f(n - 1) on n threads, the calling thread taking f(0), and waits for all of them.
+// If a thread can not be started, its part runs on the calling thread. Rethrows the first exception of f after all parts end.
+template<class F>
+void run_on_threads(size_t n, F&& f) {
+    std::vector<std::exception_ptr> Errors(n);
+    auto Run = [&f, &Errors](size_t t) {
+        try {
+            f(t);
+        } catch (...) {
+            Errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> Threads;
+    Threads.reserve(n);
+    for (size_t t = 1; t < n; ++t) {
+        try {
+            Threads.emplace_back(Run, t);
+        } catch (const std::system_error&) {
+            Run(t);
+        }
+    }
+    Run(0);
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+    for (auto& Error : Errors) {
+        if (Error) {
+            std::rethrow_exception(Error);
+        }
+    }
+}
+
+#ifdef HASH_MAP_MMAP
+// Read-only or read-write memory mapping of a whole file. Unmaps the file on destruction.
+// Failed system calls throw system error exceptions.
+class MappedFile {
+  public:
+    // Default constructor. Maps nothing.
+    MappedFile() {}
+    // Maps existing file Path for reading. Pages are shared with other processes mapping the same file.
+    explicit MappedFile(const std::string& Path) {
+        int Fd = ::open(Path.c_str(), O_RDONLY);
+        if (Fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "can not open " + Path);
+        }
+        struct stat Stat;
+        if (::fstat(Fd, &Stat) != 0) {
+            int Error = errno;
+            ::close(Fd);
+            throw std::system_error(Error, std::generic_category(), "can not stat " + Path);
+        }
+        map(Fd, static_cast<size_t>(Stat.st_size), PROT_READ, Path);
+    }
+    // Creates or truncates file Path to Size bytes and maps it for writing. Size must be nonzero.
+    MappedFile(const std::string& Path, size_t Size) {
+        int Fd = ::open(Path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (Fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "can not create " + Path);
+        }
+        if (::ftruncate(Fd, static_cast<off_t>(Size)) != 0) {
+            int Error = errno;
+            ::close(Fd);
+            throw std::system_error(Error, std::generic_category(), "can not resize " + Path);
+        }
+        map(Fd, Size, PROT_READ | PROT_WRITE, Path);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    // Move constructor in O(1) time. Oth is left empty.
+    MappedFile(MappedFile&& Oth) noexcept {
+        swap(Oth);
+    }
+    // Moves Oth to *this in O(1) time, unmapping the previous file. Oth is left empty.
+    MappedFile& operator=(MappedFile&& Oth) noexcept {
+        if (this != &Oth) {
+            MappedFile(std::move(Oth)).swap(*this);
+        }
+        return *this;
+    }
+    // Unmaps the file.
+    ~MappedFile() {
+        if (Data != nullptr) {
+            ::munmap(Data, Sz);
+        }
+    }
+    // Swaps mappings with Oth in O(1) time.
+    void swap(MappedFile& Oth) noexcept {
+        std::swap(Data, Oth.Data);
+        std::swap(Sz, Oth.Sz);
+    }
+    // Returns address of the first mapped byte in O(1) time. Mappings are page aligned.
+    unsigned char* data() const {
+        return static_cast<unsigned char*>(Data);
+    }
+    // Returns number of mapped bytes in O(1) time.
+    size_t size() const {
+        return Sz;
+    }
+    // Writes changed pages to the file and waits for the writes to complete.
+    void flush() const {
+        if (Data != nullptr && ::msync(Data, Sz, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "can not write mapped file");
+        }
+    }
+
+  private:
+    // Maps Size bytes of open file Fd with protection Prot and closes Fd.
+    void map(int Fd, size_t Size, int Prot, const std::string& Path) {
+        void* p = Size == 0 ? MAP_FAILED : ::mmap(nullptr, Size, Prot, MAP_SHARED, Fd, 0);
+        int Error = Size == 0 ? EINVAL : errno;
+        ::close(Fd);
+        if (p == MAP_FAILED) {
+            throw std::system_error(Error, std::generic_category(), "can not map " + Path);
+        }
+        Data = p;
+        Sz = Size;
+    }
+    void* Data = nullptr;
+    size_t Sz = 0;
+};
+
+// Item of a mapped hash map file. Keys and values are stored as their bytes.
+template<class KeyType, class ValueType>
+struct MappedHashMapItem {
+    KeyType first;
+    ValueType second;
+};
+
+// On-disk layout of a hash map saved by HashMap::save() and read by MappedHashMap, version 1, in native byte order.
+// The header is followed by BucketCount + 1 numbers of the first item of every bucket and the end,
+// and then by every item grouped by bucket. Item of hash h is in bucket MurmurHashMixer()(h) & (BucketCount - 1),
+// so a file is read with the same key type and Hash as it is written. Both arrays start at multiples of 64 bytes.
+struct MappedHashMapHeader {
+    static constexpr uint64_t FileMagic = 0x50414d4853414831ULL;
+    static constexpr uint32_t CurrentVersion = 1;
+    static constexpr size_t Alignment = 64;
+    // Average number of items per bucket. Items of a bucket are compared in a row, so a few per bucket cost little.
+    static constexpr size_t ItemsPerBucket = 4;
+    uint64_t Magic;
+    uint32_t Version;
+    uint32_t KeySize;
+    uint32_t ValueSize;
+    uint32_t ItemSize;
+    uint32_t ItemAlignment;
+    uint32_t Reserved;
+    uint64_t BucketCount;
+    uint64_t ItemCount;
+    uint64_t BucketsOffset;
+    uint64_t ItemsOffset;
+    uint64_t FileSize;
+    // Returns header of a file of n items of type Item with their keys and values of KeySize and ValueSize bytes.
+    template<class Item>
+    static MappedHashMapHeader make(size_t n, size_t KeySize, size_t ValueSize) {
+        MappedHashMapHeader h = {};
+        h.Magic = FileMagic;
+        h.Version = CurrentVersion;
+        h.KeySize = static_cast<uint32_t>(KeySize);
+        h.ValueSize = static_cast<uint32_t>(ValueSize);
+        h.ItemSize = static_cast<uint32_t>(sizeof(Item));
+        h.ItemAlignment = static_cast<uint32_t>(alignof(Item));
+        h.BucketCount = 1;
+        while (h.BucketCount * ItemsPerBucket < n) {
+            h.BucketCount *= 2;
+        }
+        h.ItemCount = n;
+        h.BucketsOffset = align(sizeof(MappedHashMapHeader));
+        h.ItemsOffset = align(h.BucketsOffset + (h.BucketCount + 1) * sizeof(uint64_t));
+        h.FileSize = h.ItemsOffset + n * sizeof(Item);
+        return h;
+    }
+    // Returns true if the header describes a file of FileSize bytes with items of type Item made of keys and values
+    // of KeySize and ValueSize bytes that make() could write. Works in O(1) time.
+    template<class Item>
+    bool matches(size_t Size, size_t KeySize, size_t ValueSize) const {
+        if (Magic != FileMagic || Version != CurrentVersion || this->KeySize != KeySize || this->ValueSize != ValueSize ||
+            ItemSize != sizeof(Item) || ItemAlignment != alignof(Item) || FileSize != Size) {
+            return false;
+        }
+        MappedHashMapHeader Expected = make<Item>(ItemCount, KeySize, ValueSize);
+        return BucketCount == Expected.BucketCount && BucketsOffset == Expected.BucketsOffset &&
+               ItemsOffset == Expected.ItemsOffset && FileSize == Expected.FileSize;
+    }
+    // Returns n rounded up to Alignment.
+    static uint64_t align(uint64_t n) {
+        return (n + Alignment - 1) / Alignment * Alignment;
+    }
+};
+
+// On-disk layout of a FrozenHashMap saved by FrozenHashMap::save() and read by MappedFrozenHashMap, version 2 of
+// the map file format, in native byte order. The header is followed by 16-bit pilots of BucketCount buckets,
+// by TableSize - ItemCount numbers of the positions that table positions past ItemCount are remapped to, and by
+// every item in position order. The file is read with the same key type and Hash as it is written, and Seed is the seed
+// the pilots were found for. All three arrays start at multiples of 64 bytes.
+struct MappedFrozenHashMapHeader {
+    static constexpr uint64_t FileMagic = MappedHashMapHeader::FileMagic;
+    static constexpr uint32_t CurrentVersion = 2;
+    static constexpr size_t Alignment = MappedHashMapHeader::Alignment;
+    uint64_t Magic;
+    uint32_t Version;
+    uint32_t KeySize;
+    uint32_t ValueSize;
+    uint32_t ItemSize;
+    uint32_t ItemAlignment;
+    uint32_t Reserved;
+    uint64_t BucketCount;
+    uint64_t ItemCount;
+    uint64_t TableSize;
+    uint64_t Seed;
+    uint64_t PilotsOffset;
+    uint64_t RemapOffset;
+    uint64_t ItemsOffset;
+    uint64_t FileSize;
+    // Returns header of a file of n items of type Item with their keys and values of KeySize and ValueSize bytes,
+    // placed by b pilots found for Seed into table of TableSize positions.
+    template<class Item>
+    static MappedFrozenHashMapHeader make(size_t n, size_t b, size_t TableSize, size_t Seed, size_t KeySize, size_t ValueSize) {
+        MappedFrozenHashMapHeader h = {};
+        h.Magic = FileMagic;
+        h.Version = CurrentVersion;
+        h.KeySize = static_cast<uint32_t>(KeySize);
+        h.ValueSize = static_cast<uint32_t>(ValueSize);
+        h.ItemSize = static_cast<uint32_t>(sizeof(Item));
+        h.ItemAlignment = static_cast<uint32_t>(alignof(Item));
+        h.BucketCount = b;
+        h.ItemCount = n;
+        h.TableSize = TableSize;
+        h.Seed = Seed;
+        h.PilotsOffset = MappedHashMapHeader::align(sizeof(MappedFrozenHashMapHeader));
+        h.RemapOffset = MappedHashMapHeader::align(h.PilotsOffset + b * sizeof(uint16_t));
+        h.ItemsOffset = MappedHashMapHeader::align(h.RemapOffset + (TableSize - n) * sizeof(uint64_t));
+        h.FileSize = h.ItemsOffset + n * sizeof(Item);
+        return h;
+    }
+    // Returns true if the header describes a file of FileSize bytes with items of type Item made of keys and values
+    // of KeySize and ValueSize bytes that make() could write for BucketLoad keys per bucket. Works in O(1) time.
+    template<class Item>
+    bool matches(size_t Size, size_t KeySize, size_t ValueSize, size_t BucketLoad) const {
+        if (Magic != FileMagic || Version != CurrentVersion || this->KeySize != KeySize || this->ValueSize != ValueSize ||
+            ItemSize != sizeof(Item) || ItemAlignment != alignof(Item) || FileSize != Size ||
+            BucketCount != (ItemCount + BucketLoad - 1) / BucketLoad || TableSize != ItemCount + ItemCount / 64) {
+            return false;
+        }
+        MappedFrozenHashMapHeader Expected = make<Item>(ItemCount, BucketCount, TableSize, Seed, KeySize, ValueSize);
+        return PilotsOffset == Expected.PilotsOffset && RemapOffset == Expected.RemapOffset &&
+               ItemsOffset == Expected.ItemsOffset && FileSize == Expected.FileSize;
+    }
+};
+
+// Writes a file of Size bytes to Path: maps a temporary file, lets Fill write the mapped bytes, flushes them and renames
+// the file to Path, so readers of an older file at Path keep their mapping. Throws system error exception on failure,
+// and then no file is left at the temporary path.
+template<class F>
+void write_mapped_file(const std::string& Path, size_t Size, F&& Fill) {
+    std::string TemporaryPath = Path + ".tmp";
+    try {
+        MappedFile File(TemporaryPath, Size);
+        Fill(File.data());
+        File.flush();
+    } catch (...) {
+        std::remove(TemporaryPath.c_str());
+        throw;
+    }
+    if (std::rename(TemporaryPath.c_str(), Path.c_str()) != 0) {
+        int Error = errno;
+        std::remove(TemporaryPath.c_str());
+        throw std::system_error(Error, std::generic_category(), "can not rename " + TemporaryPath);
+    }
+}
+
+// Read-only hash map over a file written by HashMap::save(), mapped into memory with no deserialization.
+// Opening takes O(1) time and reads only the header. Lookups hash the key, read two numbers of the bucket
+// and compare keys of its items, which lie in a row. Iteration is a sweep over the item array in bucket order.
+// Pages of the file are loaded on first access and shared by every process mapping it.
+// Only the header is checked on opening; bucket numbers are trusted, so files must come from HashMap::save().
+// Keys and values must be trivially copyable, the file must be written with the same key type and Hash.
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>>
+class MappedHashMap {
+    static_assert(std::is_trivially_copyable<KeyType>::value && std::is_trivially_copyable<ValueType>::value,
+                  "mapped maps need trivially copyable keys and values");
+  public:
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef MappedHashMapItem<KeyType, ValueType> value_type;
+    // Items are read-only, so iterators are constant pointers to items of the file.
+    typedef const value_type* const_iterator;
+    typedef const_iterator iterator;
+    // Maps file Path. Throws system error exception if the file can not be mapped and runtime error exception
+    // if it is not a map file of this key and value type.
+    explicit MappedHashMap(const std::string& Path, const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual())
+        : HashFunction(HashFunction), Equal(Equal), File(Path) {
+        MappedHashMapHeader Header;
+        if (File.size() < sizeof(Header)) {
+            throw std::runtime_error("incorrect map file " + Path);
+        }
+        std::memcpy(&Header, File.data(), sizeof(Header));
+        if (!Header.matches<value_type>(File.size(), sizeof(KeyType), sizeof(ValueType))) {
+            throw std::runtime_error("incorrect map file " + Path);
+        }
+        Buckets = reinterpret_cast<const uint64_t*>(File.data() + Header.BucketsOffset);
+        Items = reinterpret_cast<const value_type*>(File.data() + Header.ItemsOffset);
+        BucketCount = Header.BucketCount;
+        Sz = Header.ItemCount;
+    }
+    // Returns iterator of the first item in O(1) time.
+    const_iterator begin() const {
+        return Items;
+    }
+    // Returns end iterator in O(1) time.
+    const_iterator end() const {
+        return Items + Sz;
+    }
+    // Returns hash function in O(1) time.
+    Hash hash_function() const {
+        return HashFunction;
+    }
+    // Returns key equality function in O(1) time.
+    KeyEqual key_eq() const {
+        return Equal;
+    }
+    // Returns iterator of item by key in O(bucket size) time. If hash function is good, works in O(1) expected time.
+    const_iterator find(const KeyType& Key) const {
+        size_t b = MurmurHashMixer()(HashFunction(Key)) & (BucketCount - 1);
+        for (const value_type* i = Items + Buckets[b], *Last = Items + Buckets[b + 1]; i != Last; ++i) {
+            if (Equal(i->first, Key)) {
+                return i;
+            }
+        }
+        return end();
+    }
+    // Returns number of items with key in O(1) expected time.
+    size_t count(const KeyType& Key) const {
+        return find(Key) != end();
+    }
+    // Returns true if an item with key is stored in O(1) expected time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns item by key in O(1) expected time. If no items stored by this key, throws out of range exception.
+    const ValueType& at(const KeyType& Key) const {
+        const_iterator i = find(Key);
+        if (i == end()) {
+            throw std::out_of_range("incorrect key");
+        }
+        return i->second;
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Sz;
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return Sz == 0;
+    }
+    // Returns number of buckets in O(1) time.
+    size_t bucket_count() const {
+        return BucketCount;
+    }
+
+  private:
+    Hash HashFunction;
+    KeyEqual Equal;
+    MappedFile File;
+    const uint64_t* Buckets = nullptr;
+    const value_type* Items = nullptr;
+    size_t BucketCount = 0;
+    size_t Sz = 0;
+};
+#endif
+
+#ifdef HASH_MAP_MMAP
+template<class KeyType, class ValueType, class Hash, class KeyEqual>
+class MappedFrozenHashMap;
+#endif
+
+// Immutable hash map with minimal perfect hashing in the style of PTHash, for tables built once and then only read.
+// Keys are split into skewed buckets and every bucket gets the least 16-bit pilot that sends its keys to free
+// positions of a table of size() + size() / 64 positions. Positions past size() are remapped to the free positions
+// below it, so items lie in a row without gaps. Lookup hashes the key once, reads the pilot of its bucket and
+// compares the key of one item, with no probing. Construction takes O(n log n) expected time.
+// Keys with different values and equal hashes can not be told apart by any pilot, so they are rejected.
+// save() writes pilots, remapped positions and items to a file which MappedFrozenHashMap reads without rebuilding.
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>,
+         class Allocator = std::allocator<std::pair<const KeyType, ValueType>>>
+class FrozenHashMap {
+  public:
+    // Average number of keys per bucket.
+    static constexpr size_t BucketLoad = 4;
+    // Number of pilots tried for a bucket before construction starts again with another seed.
+    static constexpr size_t PilotCount = size_t(1) << 16;
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef Allocator allocator_type;
+    // Items are read-only, so iterators are constant pointers to items.
+    typedef const value_type* const_iterator;
+    typedef const_iterator iterator;
+    // Default constructor. Builds empty map.
+    FrozenHashMap() {}
+    // Constructor for begin and end iterators. If keys repeat, the first item with the key is stored.
+    // Throws invalid argument exception if hashes of different keys are equal.
+    template<class Iterator>
+    FrozenHashMap(Iterator first, Iterator last, const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual(),
+                  const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Items(Alloc) {
+        build(first, last);
+    }
+    // Constructor for initializer list. If keys repeat, the first item with the key is stored.
+    FrozenHashMap(std::initializer_list<value_type> List, const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual(),
+                  const Allocator& Alloc = Allocator())
+        : FrozenHashMap(List.begin(), List.end(), HashFunction, Equal, Alloc) {}
+    // Returns iterator of the first item in O(1) time.
+    const_iterator begin() const {
+        return Items.data();
+    }
+    // Returns end iterator in O(1) time.
+    const_iterator end() const {
+        return Items.data() + Items.size();
+    }
+    // Returns hash function in O(1) time.
+    Hash hash_function() const {
+        return HashFunction;
+    }
+    // Returns key equality function in O(1) time.
+    KeyEqual key_eq() const {
+        return Equal;
+    }
+    // Returns allocator in O(1) time.
+    Allocator get_allocator() const {
+        return Items.get_allocator();
+    }
+    // Returns iterator of item by key in O(1) time.
+    const_iterator find(const KeyType& Key) const {
+        if (Items.empty()) {
+            return end();
+        }
+        const value_type* i = Items.data() + position(HashFunction(Key));
+        return Equal(i->first, Key) ? i : end();
+    }
+    // Returns number of items with key in O(1) time.
+    size_t count(const KeyType& Key) const {
+        return find(Key) != end();
+    }
+    // Returns true if an item with key is stored in O(1) time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns item by key in O(1) time. If no items stored by this key, throws out of range exception.
+    const ValueType& at(const KeyType& Key) const {
+        const_iterator i = find(Key);
+        if (i == end()) {
+            throw std::out_of_range("incorrect key");
+        }
+        return i->second;
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Items.size();
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return Items.empty();
+    }
+    // Returns number of buckets in O(1) time.
+    size_t bucket_count() const {
+        return Pilots.size();
+    }
+#ifdef HASH_MAP_MMAP
+    typedef MappedFrozenHashMap<KeyType, ValueType, Hash, KeyEqual> mapped_view_type;
+    // Writes pilots, remapped positions and items to file Path in the format of MappedFrozenHashMapHeader in O(size) time,
+    // so that open_mapped() can read it without rebuilding. The file is written under a temporary name and renamed,
+    // so readers of an older file at Path keep their mapping. Throws system error exception on failure.
+    // Keys and values must be trivially copyable.
+    void save(const std::string& Path) const {
+        static_assert(std::is_trivially_copyable<KeyType>::value && std::is_trivially_copyable<ValueType>::value,
+                      "saved maps need trivially copyable keys and values");
+        typedef typename mapped_view_type::value_type item_type;
+        MappedFrozenHashMapHeader Header = MappedFrozenHashMapHeader::make<item_type>(Items.size(), Pilots.size(), TableSize, Seed,
+                                                                                      sizeof(KeyType), sizeof(ValueType));
+        write_mapped_file(Path, Header.FileSize, [this, &Header](unsigned char* Data) {
+            std::memcpy(Data, &Header, sizeof(Header));
+            if (!Pilots.empty()) {
+                std::memcpy(Data + Header.PilotsOffset, Pilots.data(), Pilots.size() * sizeof(uint16_t));
+            }
+            uint64_t* MappedRemap = reinterpret_cast<uint64_t*>(Data + Header.RemapOffset);
+            for (size_t i = 0; i != Remap.size(); ++i) {
+                MappedRemap[i] = Remap[i];
+            }
+            for (size_t i = 0; i != Items.size(); ++i) {
+                item_type Item;
+                std::memset(static_cast<void*>(&Item), 0, sizeof(Item));
+                std::memcpy(static_cast<void*>(&Item.first), &Items[i].first, sizeof(KeyType));
+                std::memcpy(static_cast<void*>(&Item.second), &Items[i].second, sizeof(ValueType));
+                std::memcpy(Data + Header.ItemsOffset + i * sizeof(item_type), &Item, sizeof(Item));
+            }
+        });
+    }
+    // Returns read-only view of a map file written by save() in O(1) time. Items are read from the mapped file on access.
+    // Throws system error exception if the file can not be mapped and runtime error exception if it is not a frozen map file.
+    static mapped_view_type open_mapped(const std::string& Path, const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual()) {
+        return mapped_view_type(Path, HashFunction, Equal);
+    }
+#endif
+
+  private:
+#ifdef HASH_MAP_MMAP
+    friend class MappedFrozenHashMap<KeyType, ValueType, Hash, KeyEqual>;
+#endif
+    // Item number of free table positions during construction.
+    static constexpr size_t EmptyPosition = ~size_t(0);
+    // Returns mixed hash h of the key for seed s in O(1) time. Bucket and position are taken from it.
+    static size_t mix(size_t h, size_t s) {
+        return MurmurHashMixer()(h ^ s);
+    }
+    // Returns mixed hash h of the key in the current seed in O(1) time.
+    size_t mix(size_t h) const {
+        return mix(h, Seed);
+    }
+    // Returns bucket of mixed hash x among b buckets in O(1) time. Three fifths of keys go to the dense three tenths
+    // of buckets, which are placed first while the table is empty, so that later buckets are small.
+    static size_t bucket(size_t x, size_t b) {
+        size_t Dense = std::max<size_t>(1, b * 3 / 10);
+        size_t Sparse = b - Dense;
+        return Sparse == 0 || static_cast<uint32_t>(x) < 0x99999999u ? reduce_range(x, Dense) : Dense + reduce_range(x, Sparse);
+    }
+    // Returns bucket of mixed hash x in O(1) time.
+    size_t bucket(size_t x) const {
+        return bucket(x, Pilots.size());
+    }
+    // Returns position of mixed hash x with pilot p in table of n positions in O(1) time. Positions may be past size() before remapping.
+    static size_t table_position(size_t x, size_t p, size_t n) {
+        return reduce_range(MurmurHashMixer()(x ^ 0x9e3779b97f4a7c15ULL) ^ MurmurHashMixer()(p + 1), n);
+    }
+    // Returns table position of mixed hash x with pilot p in O(1) time.
+    size_t table_position(size_t x, size_t p) const {
+        return table_position(x, p, TableSize);
+    }
+    // Returns position of item with key of hash h in O(1) time.
+    size_t position(size_t h) const {
+        size_t x = mix(h);
+        size_t i = table_position(x, Pilots[bucket(x)]);
+        return i < Items.size() ? i : Remap[i - Items.size()];
+    }
+    // Builds the map of items of range [first, last).
+    template<class Iterator>
+    void build(Iterator first, Iterator last) {
+        std::vector<Iterator> Sources;
+        std::vector<std::pair<size_t, size_t>> Hashes;
+        for (auto i = first; i != last; ++i) {
+            Hashes.emplace_back(HashFunction(i->first), Sources.size());
+            Sources.push_back(i);
+        }
+        // Sorting by hash and then by input order puts repeated keys together, first input first.
+        std::sort(Hashes.begin(), Hashes.end());
+        size_t n = 0;
+        for (size_t i = 0; i != Hashes.size(); ++i) {
+            bool Repeated = false;
+            for (size_t j = n; j != 0 && Hashes[j - 1].first == Hashes[i].first; --j) {
+                if (!Equal(Sources[Hashes[j - 1].second]->first, Sources[Hashes[i].second]->first)) {
+                    throw std::invalid_argument("keys with equal hashes");
+                }
+                Repeated = true;
+            }
+            if (!Repeated) {
+                Hashes[n++] = Hashes[i];
+            }
+        }
+        Hashes.resize(n);
+        if (n == 0) {
+            return;
+        }
+        TableSize = n + n / 64;
+        std::vector<size_t> Order;
+        while (!place(Hashes, Order)) {
+            ++Seed;
+        }
+        Items.reserve(n);
+        for (size_t i = 0; i != n; ++i) {
+            Items.emplace_back(*Sources[Order[i]]);
+        }
+    }
+    // Tries to find pilots of every bucket in the current seed for keys with hashes and input numbers Hashes.
+    // On success sets Remap and item number of every position to Order and returns true. Works in O(n log n) expected time.
+    bool place(const std::vector<std::pair<size_t, size_t>>& Hashes, std::vector<size_t>& Order) {
+        size_t n = Hashes.size();
+        Pilots.assign((n + BucketLoad - 1) / BucketLoad, 0);
+        size_t b = Pilots.size();
+        // Counting sort of keys by bucket and then of buckets by size, largest first.
+        std::vector<size_t> Mixed(n), BucketStart(b + 1), Keys(n);
+        for (size_t i = 0; i != n; ++i) {
+            Mixed[i] = mix(Hashes[i].first);
+            ++BucketStart[bucket(Mixed[i]) + 1];
+        }
+        size_t Largest = 0;
+        for (size_t i = 0; i != b; ++i) {
+            Largest = std::max(Largest, BucketStart[i + 1]);
+            BucketStart[i + 1] += BucketStart[i];
+        }
+        std::vector<size_t> Next(BucketStart.begin(), BucketStart.end() - 1);
+        for (size_t i = 0; i != n; ++i) {
+            Keys[Next[bucket(Mixed[i])]++] = i;
+        }
+        std::vector<size_t> SizeStart(Largest + 2), Buckets(b);
+        for (size_t i = 0; i != b; ++i) {
+            ++SizeStart[Largest - (BucketStart[i + 1] - BucketStart[i]) + 1];
+        }
+        for (size_t s = 0; s != Largest + 1; ++s) {
+            SizeStart[s + 1] += SizeStart[s];
+        }
+        for (size_t i = 0; i != b; ++i) {
+            Buckets[SizeStart[Largest - (BucketStart[i + 1] - BucketStart[i])]++] = i;
+        }
+        std::vector<uint64_t> Taken((TableSize + 63) / 64);
+        Order.assign(TableSize, EmptyPosition);
+        for (size_t Bucket : Buckets) {
+            size_t First = BucketStart[Bucket], Last = BucketStart[Bucket + 1];
+            if (First == Last) {
+                break;
+            }
+            size_t p = 0;
+            for (; p != PilotCount; ++p) {
+                size_t k = First;
+                for (; k != Last; ++k) {
+                    size_t i = table_position(Mixed[Keys[k]], p);
+                    if ((Taken[i / 64] >> (i % 64) & 1) != 0) {
+                        break;
+                    }
+                    Taken[i / 64] |= uint64_t(1) << (i % 64);
+                }
+                if (k == Last) {
+                    break;
+                }
+                while (k-- != First) {
+                    size_t i = table_position(Mixed[Keys[k]], p);
+                    Taken[i / 64] &= ~(uint64_t(1) << (i % 64));
+                }
+            }
+            if (p == PilotCount) {
+                return false;
+            }
+            Pilots[Bucket] = static_cast<uint16_t>(p);
+            for (size_t k = First; k != Last; ++k) {
+                Order[table_position(Mixed[Keys[k]], p)] = Hashes[Keys[k]].second;
+            }
+        }
+        // Taken positions past n move to free positions below n in increasing order of both.
+        Remap.assign(TableSize - n, 0);
+        size_t Free = 0;
+        for (size_t i = n; i != TableSize; ++i) {
+            if (Order[i] != EmptyPosition) {
+                while (Order[Free] != EmptyPosition) {
+                    ++Free;
+                }
+                Order[Free] = Order[i];
+                Remap[i - n] = Free;
+            }
+        }
+        Order.resize(n);
+        return true;
+    }
+    Hash HashFunction;
+    KeyEqual Equal;
+    std::vector<value_type, Allocator> Items;
+    std::vector<uint16_t> Pilots;
+    std::vector<size_t> Remap;
+    size_t TableSize = 0;
+    size_t Seed = 0;
+};
+
+#ifdef HASH_MAP_MMAP
+// Read-only minimal perfect hash map over a file written by FrozenHashMap::save(), mapped into memory with no rebuilding.
+// Opening takes O(1) time and reads only the header. Lookups hash the key, read the pilot of its bucket and, for the few
+// positions past size(), their remapped position, and compare the key of one item. Iteration is a sweep over the items.
+// Only the header is checked on opening; pilots and remapped positions are trusted, so files must come from
+// FrozenHashMap::save(). Keys and values must be trivially copyable, the file must be written with the same key type and Hash.
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>>
+class MappedFrozenHashMap {
+    static_assert(std::is_trivially_copyable<KeyType>::value && std::is_trivially_copyable<ValueType>::value,
+                  "mapped maps need trivially copyable keys and values");
+    typedef FrozenHashMap<KeyType, ValueType, Hash, KeyEqual> frozen_type;
+  public:
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef MappedHashMapItem<KeyType, ValueType> value_type;
+    // Items are read-only, so iterators are constant pointers to items of the file.
+    typedef const value_type* const_iterator;
+    typedef const_iterator iterator;
+    // Maps file Path. Throws system error exception if the file can not be mapped and runtime error exception
+    // if it is not a frozen map file of this key and value type.
+    explicit MappedFrozenHashMap(const std::string& Path, const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual())
+        : HashFunction(HashFunction), Equal(Equal), File(Path) {
+        MappedFrozenHashMapHeader Header;
+        if (File.size() < sizeof(Header)) {
+            throw std::runtime_error("incorrect frozen map file " + Path);
+        }
+        std::memcpy(&Header, File.data(), sizeof(Header));
+        if (!Header.matches<value_type>(File.size(), sizeof(KeyType), sizeof(ValueType), frozen_type::BucketLoad)) {
+            throw std::runtime_error("incorrect frozen map file " + Path);
+        }
+        Pilots = reinterpret_cast<const uint16_t*>(File.data() + Header.PilotsOffset);
+        Remap = reinterpret_cast<const uint64_t*>(File.data() + Header.RemapOffset);
+        Items = reinterpret_cast<const value_type*>(File.data() + Header.ItemsOffset);
+        BucketCount = Header.BucketCount;
+        TableSize = Header.TableSize;
+        Seed = Header.Seed;
+        Sz = Header.ItemCount;
+    }
+    // Returns iterator of the first item in O(1) time.
+    const_iterator begin() const {
+        return Items;
+    }
+    // Returns end iterator in O(1) time.
+    const_iterator end() const {
+        return Items + Sz;
+    }
+    // Returns hash function in O(1) time.
+    Hash hash_function() const {
+        return HashFunction;
+    }
+    // Returns key equality function in O(1) time.
+    KeyEqual key_eq() const {
+        return Equal;
+    }
+    // Returns iterator of item by key in O(1) time.
+    const_iterator find(const KeyType& Key) const {
+        if (Sz == 0) {
+            return end();
+        }
+        size_t x = frozen_type::mix(HashFunction(Key), Seed);
+        size_t i = frozen_type::table_position(x, Pilots[frozen_type::bucket(x, BucketCount)], TableSize);
+        const value_type* Item = Items + (i < Sz ? i : Remap[i - Sz]);
+        return Equal(Item->first, Key) ? Item : end();
+    }
+    // Returns number of items with key in O(1) time.
+    size_t count(const KeyType& Key) const {
+        return find(Key) != end();
+    }
+    // Returns true if an item with key is stored in O(1) time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns item by key in O(1) time. If no items stored by this key, throws out of range exception.
+    const ValueType& at(const KeyType& Key) const {
+        const_iterator i = find(Key);
+        if (i == end()) {
+            throw std::out_of_range("incorrect key");
+        }
+        return i->second;
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Sz;
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return Sz == 0;
+    }
+    // Returns number of buckets in O(1) time.
+    size_t bucket_count() const {
+        return BucketCount;
+    }
+
+  private:
+    Hash HashFunction;
+    KeyEqual Equal;
+    MappedFile File;
+    const uint16_t* Pilots = nullptr;
+    const uint64_t* Remap = nullptr;
+    const value_type* Items = nullptr;
+    size_t BucketCount = 0;
+    size_t TableSize = 0;
+    size_t Seed = 0;
+    size_t Sz = 0;
+};
+#endif
+
+// Hash function computable at compile time, for ConstantHashMap. Defined for integers, enumerations and string views.
+template<class KeyType, class Enable = void>
+struct ConstantHash;
+
+// Compile-time hash of integers and enumerations: their value mixed by MurmurHashMixer.
+template<class KeyType>
+struct ConstantHash<KeyType, typename std::enable_if<std::is_integral<KeyType>::value || std::is_enum<KeyType>::value>::type> {
+    // Returns hash of Key in O(1) time.
+    constexpr size_t operator()(KeyType Key) const {
+        return MurmurHashMixer()(static_cast<size_t>(Key));
+    }
+};
+
+// Compile-time hash of strings: 64-bit FNV-1a of their characters mixed by MurmurHashMixer.
+template<>
+struct ConstantHash<std::string_view> {
+    // Returns hash of Key in O(length) time.
+    constexpr size_t operator()(std::string_view Key) const {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c : Key) {
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+        }
+        return MurmurHashMixer()(static_cast<size_t>(h));
+    }
+};
+
+// Immutable hash map of N items fully built at compile time when constructed in a constexpr context, with no heap
+// and no startup cost. Items lie in an array in construction order; a table of the least power of two positions
+// not less than 2 * N holds their numbers, resolving collisions by linear probing, so lookups probe O(1) positions.
+// Numbers take one byte for up to 254 items and two for up to 65534. Lookups are constexpr, so lookups of literal
+// keys in a constexpr map can be folded at compile time. Hash and KeyEqual must be constexpr, as ConstantHash is.
+// Made by make_constant_hash_map(), which deduces N from the list of items.
+template<class KeyType, class ValueType, size_t N, class Hash = ConstantHash<KeyType>, class KeyEqual = std::equal_to<KeyType>>
+class ConstantHashMap {
+    static_assert(N > 0, "ConstantHashMap needs items");
+  public:
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef typename std::conditional<(N < 0xff), uint8_t, typename std::conditional<(N < 0xffff), uint16_t, size_t>::type>::type index_type;
+    // Items are read-only, so iterators are constant pointers to items.
+    typedef const value_type* const_iterator;
+    typedef const_iterator iterator;
+    // Number of table positions.
+    static constexpr size_t Capacity = [] {
+        size_t c = 1;
+        while (c < 2 * N) {
+            c *= 2;
+        }
+        return c;
+    }();
+    // Constructor for array of items in O(N) expected time. Throws invalid argument exception if keys repeat,
+    // which fails compilation in a constexpr context.
+    constexpr explicit ConstantHashMap(const value_type (&List)[N], const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual())
+        : ConstantHashMap(List, HashFunction, Equal, std::make_index_sequence<N>()) {}
+    // Returns iterator of the first item in O(1) time.
+    constexpr const_iterator begin() const {
+        return Items;
+    }
+    // Returns end iterator in O(1) time.
+    constexpr const_iterator end() const {
+        return Items + N;
+    }
+    // Returns hash function in O(1) time.
+    constexpr Hash hash_function() const {
+        return HashFunction;
+    }
+    // Returns key equality function in O(1) time.
+    constexpr KeyEqual key_eq() const {
+        return Equal;
+    }
+    // Returns iterator of item by key in O(1) expected time.
+    constexpr const_iterator find(const KeyType& Key) const {
+        for (size_t i = HashFunction(Key) & (Capacity - 1);; i = (i + 1) & (Capacity - 1)) {
+            if (Index[i] == N) {
+                return end();
+            }
+            if (Equal(Items[Index[i]].first, Key)) {
+                return Items + Index[i];
+            }
+        }
+    }
+    // Returns number of items with key in O(1) expected time.
+    constexpr size_t count(const KeyType& Key) const {
+        return find(Key) != end();
+    }
+    // Returns true if an item with key is stored in O(1) expected time.
+    constexpr bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns item by key in O(1) expected time. If no items stored by this key, throws out of range exception,
+    // which fails compilation in a constexpr context.
+    constexpr const ValueType& at(const KeyType& Key) const {
+        const_iterator i = find(Key);
+        if (i == end()) {
+            throw std::out_of_range("incorrect key");
+        }
+        return i->second;
+    }
+    // Returns number of stored items in O(1) time.
+    constexpr size_t size() const {
+        return N;
+    }
+    // Returns false in O(1) time: the container always stores N items.
+    constexpr bool empty() const {
+        return false;
+    }
+    // Returns number of table positions in O(1) time.
+    constexpr size_t bucket_count() const {
+        return Capacity;
+    }
+
+  private:
+    // Copies items in O(N) time and puts their numbers to the table in O(N) expected time.
+    template<size_t... I>
+    constexpr ConstantHashMap(const value_type (&List)[N], const Hash& HashFunction, const KeyEqual& Equal, std::index_sequence<I...>)
+        : HashFunction(HashFunction), Equal(Equal), Items{List[I]...}, Index{} {
+        for (size_t i = 0; i != Capacity; ++i) {
+            Index[i] = static_cast<index_type>(N);
+        }
+        for (size_t j = 0; j != N; ++j) {
+            size_t i = HashFunction(Items[j].first) & (Capacity - 1);
+            for (; Index[i] != N; i = (i + 1) & (Capacity - 1)) {
+                if (Equal(Items[Index[i]].first, Items[j].first)) {
+                    throw std::invalid_argument("repeated key");
+                }
+            }
+            Index[i] = static_cast<index_type>(j);
+        }
+    }
+    Hash HashFunction;
+    KeyEqual Equal;
+    value_type Items[N];
+    index_type Index[Capacity];
+};
+
+// Returns ConstantHashMap of items of List in O(N) expected time, at compile time in a constexpr context.
+// Throws invalid argument exception if keys repeat.
+template<class KeyType, class ValueType, class Hash = ConstantHash<KeyType>, class KeyEqual = std::equal_to<KeyType>, size_t N>
+constexpr ConstantHashMap<KeyType, ValueType, N, Hash, KeyEqual> make_constant_hash_map(const std::pair<const KeyType, ValueType> (&List)[N]) {
+    return ConstantHashMap<KeyType, ValueType, N, Hash, KeyEqual>(List);
+}
+
+// Event counters of HashMap. Counted only if HASH_MAP_STATS is defined; otherwise maps have no counters and
+// report zeros, so that statistics cost nothing when they are off.
+struct HashMapCounters {
+    // Resizes because the table became dense, or buckets split by incremental growth policies.
+    size_t GrowRehashes = 0;
+    // Resizes because the table became sparse, or buckets merged by incremental growth policies.
+    size_t ShrinkRehashes = 0;
+    // Resizes requested by rehash() and reserve(), or made up front for a known number of items to insert.
+    size_t ExplicitRehashes = 0;
+    // Items moved by resizes of every kind.
+    size_t RehashedItems = 0;
+    // Rehashes with a new seed or switches to keyed hashing because keys flooded a bucket.
+    size_t FloodReseeds = 0;
+};
+
+// Snapshot of HashMap internals returned by HashMap::stats(). Long chains and many equal hashes
+// show a Hash that degrades lookups from O(1) toward O(size).
+struct HashMapStats {
+    size_t Size = 0;
+    size_t BucketCount = 0;
+    // Buckets holding at least one item.
+    size_t OccupiedBuckets = 0;
+    size_t MaxChainLength = 0;
+    // Number of buckets holding every number of items: ChainLengths[k] buckets hold k items.
+    std::vector<size_t> ChainLengths;
+    // Items sharing a bucket with an earlier item of the bucket.
+    size_t BucketCollisions = 0;
+    // Sum over items of the number of items before them in their bucket.
+    size_t SuccessfulProbes = 0;
+    // Items whose full hash equals hash of an earlier item of their bucket. Such items differ only by KeyEqual.
+    size_t HashCollisions = 0;
+    // Bytes held by the table, buckets and occupancy bitmap, including unused capacity.
+    size_t AllocatedBytes = 0;
+    HashMapCounters Counters;
+    // Returns average number of items compared by lookups of stored keys in O(1) time.
+    double average_successful_probes() const {
+        return Size == 0 ? 0 : (static_cast<double>(Size) + static_cast<double>(SuccessfulProbes)) / Size;
+    }
+    // Returns average number of items compared by lookups of absent keys, over buckets, in O(1) time.
+    double average_unsuccessful_probes() const {
+        return BucketCount == 0 ? 0 : static_cast<double>(Size) / BucketCount;
+    }
+    // Returns share of items whose hash equals hash of another item in O(1) time.
+    double hash_collision_rate() const {
+        return Size == 0 ? 0 : static_cast<double>(HashCollisions) / Size;
+    }
+};
 
 // Bucket hash table with linear iteration guarantee.
 // Iterators are implemented by storing bucket index and item index.
 // Hash table resizes itself to keep O(1) items per bucket and use O(items number) memory.
+// Average number of items per bucket is bounded by max_load_factor(), bucket counts are chosen by GrowthPolicy.
+// Items are relocated by moving both key and value (see HashMapSlot), so rehashing never copies them.
+// With an incremental GrowthPolicy (LinearGrowthPolicy) the table grows and shrinks by one bucket at a time.
 // https://programming.guide/hash-tables.html
-template<class KeyType, class ValueType, class Hash = std::hash<KeyType>>
+// Keys are compared by KeyEqual. If both Hash and KeyEqual are transparent, lookups accept any key type they support.
+// Allocator is rebound for buckets and the table, and the table passes it on to every bucket it creates.
+// An empty map has no buckets and does not allocate memory, the first insertion adds one.
+// Bulk insertion and large explicit rehashes run on several threads: items are partitioned by bucket ranges, so every thread
+// fills its own buckets and the table needs no locks (see parallel_insert() and resize()). Growth on insertion stays on
+// the calling thread, but parallel_insert(), and rehash() and reserve() of tables of at least 2 * ParallelGrain items
+// call Hash from several threads at once, so then Hash must be safe to call from several threads.
+// If StoreHash is true, every item keeps its full hash: resizing does not call the hash function and lookups compare
+// keys only on equal hashes. Worth it for keys which are slow to hash or compare, such as long strings.
+// Against hash flooding every map mixes a random seed into hashes before taking bucket numbers, so iteration order
+// differs between maps and runs unless reseed() sets the seed. Inserting into a chain far longer than chance allows
+// rehashes with a new seed or, if the chain items have equal hashes, switches to keyed SipHash (see defend()).
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>, class GrowthPolicy = PrimeGrowthPolicy,
+         class Allocator = std::allocator<std::pair<const KeyType, ValueType>>, bool StoreHash = false>
 class HashMap {
   public:
-    static constexpr size_t LoadFactor = 10;
-    static constexpr size_t ResizeFactor = 2;
-    typedef HashMapIterator<std::pair<const KeyType, ValueType>> iterator;
-    typedef HashMapConstIterator<std::pair<const KeyType, ValueType>> const_iterator;
+    static constexpr float DefaultMaxLoadFactor = 1;
+    // Least number of items per thread worth running in parallel.
+    static constexpr size_t ParallelGrain = 1 << 16;
+    // Number of chunks of old buckets per thread in parallel resize, see parallel_move().
+    static constexpr size_t ParallelChunks = 8;
+    // Number of keys whose lookups overlap in find_batch() and contains_batch().
+    static constexpr size_t BatchSize = 16;
+    // Length of chains, beyond four times max_load_factor(), which a good hash function virtually never makes.
+    // Inserting into such a chain reseeds the table, see defend().
+    static constexpr size_t FloodChainLength = 16;
+    // True if the map may replace Hash by SipHash when keys flood one bucket with equal hashes: keys are integers,
+    // enumerations or strings compared by std::equal_to, so that hashing their values is consistent with KeyEqual.
+    static constexpr bool KeyedFallback = IsSipHashable<KeyType>::value && !std::is_same<Hash, SipHash>::value &&
+                                          (std::is_same<KeyEqual, std::equal_to<KeyType>>::value || std::is_same<KeyEqual, std::equal_to<>>::value);
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef Allocator allocator_type;
+    typedef HashMapSlot<KeyType, ValueType, StoreHash> slot_type;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type> slot_allocator_type;
+    typedef std::vector<slot_type, slot_allocator_type> bucket_type;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<bucket_type> bucket_allocator_type;
+    typedef std::vector<bucket_type, std::scoped_allocator_adaptor<bucket_allocator_type, slot_allocator_type>> table_type;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<uint64_t> occupancy_allocator_type;
+    typedef std::vector<uint64_t, occupancy_allocator_type> occupancy_type;
+    typedef HashMapIterator<table_type, occupancy_type> iterator;
+    typedef HashMapConstIterator<table_type, occupancy_type> const_iterator;
+    // Enables lookup overloads for key type K if Hash and KeyEqual are transparent.
+    template<class K>
+    using TransparentKey = typename std::enable_if<IsTransparentLookup<Hash, KeyEqual>::value && !std::is_convertible<const K&, iterator>::value &&
+                                                   (!KeyedFallback || IsSipHashable<K>::value), K>::type;
+    // Default constructor.
+    HashMap() {
+        initialize();
+    }
+    // Constructor for begin and end iterators. Sizes table once if iterators are random access.
+    template<class Iterator>
+    HashMap(Iterator first, Iterator last) {
+        initialize();
+        presize(first, last);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for begin and end iterators with expected number of items. Sizes table once for SizeHint items.
+    template<class Iterator>
+    HashMap(Iterator first, Iterator last, size_t SizeHint) {
+        initialize();
+        presize(SizeHint);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list.
+    HashMap(std::initializer_list<std::pair<KeyType, ValueType>> List) {
+        initialize();
+        presize(List.size());
+        for (auto i : List) {
+            insert(i);
+        }
+    }
+    // Default constructor with allocator.
+    explicit HashMap(const Allocator& Alloc): Table(typename table_type::allocator_type(bucket_allocator_type(Alloc), slot_allocator_type(Alloc))), Occupied(occupancy_allocator_type(Alloc)) {
+        initialize();
+    }
+    // Default constructor with custom hash function, key equality and allocator.
+    HashMap(const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Table(typename table_type::allocator_type(bucket_allocator_type(Alloc), slot_allocator_type(Alloc))), Occupied(occupancy_allocator_type(Alloc)) {
+        initialize();
+    }
+    // Constructor for begin and end iterators with custom hash function, key equality and allocator.
+    template<class Iterator>
+    HashMap(Iterator first, Iterator last, const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Table(typename table_type::allocator_type(bucket_allocator_type(Alloc), slot_allocator_type(Alloc))), Occupied(occupancy_allocator_type(Alloc)) {
+        initialize();
+        presize(first, last);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list with custom hash function, key equality and allocator.
+    HashMap(std::initializer_list<std::pair<KeyType, ValueType>> List, const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Table(typename table_type::allocator_type(bucket_allocator_type(Alloc), slot_allocator_type(Alloc))), Occupied(occupancy_allocator_type(Alloc)) {
+        initialize();
+        presize(List.size());
+        for (auto i : List) {
+            insert(i);
+        }
+    }
+    // Copy constructor. Copies buckets as they are in O(size + buckets) time, without calling the hash function.
+    HashMap(const HashMap& Oth) = default;
+    // Move constructor in O(1) time. Oth is left empty. Does not throw unless moving Hash, KeyEqual or GrowthPolicy throws.
+    HashMap(HashMap&& Oth) noexcept(std::is_nothrow_move_constructible<Hash>::value && std::is_nothrow_move_constructible<KeyEqual>::value &&
+                                    std::is_nothrow_move_constructible<GrowthPolicy>::value)
+        : HashFunction(std::move(Oth.HashFunction)), Equal(std::move(Oth.Equal)), Growth(std::move(Oth.Growth)), Table(std::move(Oth.Table)), Occupied(std::move(Oth.Occupied)),
+          FirstOccupied(Oth.FirstOccupied), Sz(Oth.Sz), MaxLoadFactor(Oth.MaxLoadFactor), MinBucketCount(Oth.MinBucketCount),
+          Seed(Oth.Seed), Keyed(Oth.Keyed), FloodLimitShift(Oth.FloodLimitShift) {
+#ifdef HASH_MAP_STATS
+        Counters = Oth.Counters;
+#endif
+        Oth.Sz = 0;
+        Oth.MinBucketCount = 0;
+        Oth.Table.clear();
+        Oth.initialize();
+    }
+    // Returns begin iterator pointing to the first item in O(1) time.
+    iterator begin() {
+        if (empty()) {
+            return end();
+        }
+        return get_iterator(FirstOccupied);
+    }
+    // Returns end iterator in O(1) time.
+    iterator end() {
+        return get_iterator(Table.size());
+    }
+    // Returns constanst begin iterator pointing to the first item in O(1) time.
+    const_iterator begin() const {
+        if (empty()) {
+            return end();
+        }
+        return get_iterator(FirstOccupied);
+    }
+    // Returns constanst end iterator in O(1) time.
+    const_iterator end() const {
+        return get_iterator(Table.size());
+    }
+    // Returns hash function in O(1) time.
+    Hash hash_function() const {
+        return HashFunction;
+    }
+    // Returns seed mixed into hashes before they are turned into bucket numbers in O(1) time.
+    size_t seed() const {
+        return Seed;
+    }
+    // Sets seed mixed into hashes, for example to get the same iteration order in every run, and rehashes table
+    // in O(size + buckets) time. Every map starts with a random seed. Invalidates iterators.
+    void reseed(size_t NewSeed) {
+        reseed_table(NewSeed, Keyed);
+    }
+    // Returns key equality function in O(1) time.
+    KeyEqual key_eq() const {
+        return Equal;
+    }
+    // Returns allocator in O(1) time.
+    Allocator get_allocator() const {
+        return Allocator(Table.get_allocator().outer_allocator());
+    }
+    // Inserts copy of item if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(const value_type& Item) {
+        return emplace_key(Item.first, Item);
+    }
+    // Inserts item by moving it if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(value_type&& Item) {
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Inserts item constructed from Item, for example from a pair with mutable key, if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class P, class = typename std::enable_if<std::is_constructible<value_type, P&&>::value>::type>
+    std::pair<iterator, bool> insert(P&& Item) {
+        return emplace(std::forward<P>(Item));
+    }
+    // Constructs item from args if its key is absent in O(1) amortized time. Arguments which are a key and a value
+    // or one pair are constructed only on insertion, other arguments are first constructed into a temporary pair.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return emplace_decomposed(std::forward<Args>(args)...);
+    }
+    // Constructs item from key and args if the key is absent in O(1) amortized time, otherwise leaves args untouched.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const KeyType& Key, Args&&... args) {
+        return emplace_key(Key, std::piecewise_construct, std::forward_as_tuple(Key), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Constructs item from moved key and args if the key is absent in O(1) amortized time, otherwise leaves key and args untouched.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(KeyType&& Key, Args&&... args) {
+        return emplace_key(Key, std::piecewise_construct, std::forward_as_tuple(std::move(Key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Assigns Obj to item by key or inserts a new item if the key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const KeyType& Key, M&& Obj) {
+        auto Result = try_emplace(Key, std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Assigns Obj to item by moved key or inserts a new item if the key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(KeyType&& Key, M&& Obj) {
+        auto Result = try_emplace(std::move(Key), std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Moves items of Oth whose keys are absent into the map in O(size + Oth.size + Oth.buckets / 64) expected time.
+    // Sizes table once, then moves slots of occupied buckets of Oth, hashing every key once and reusing stored hashes
+    // when possible. Items whose keys are present stay in Oth, like with std::unordered_map::merge(), and Oth does not
+    // shrink. If the map is empty, Hash and KeyEqual are stateless and allocators are equal, takes the table of Oth
+    // instead, without moving items. May invalidate iterators of both maps.
+    void merge(HashMap& Oth) {
+        if (this == &Oth || Oth.empty()) {
+            return;
+        }
+        if (empty() && std::is_empty<Hash>::value && std::is_empty<KeyEqual>::value && Table.get_allocator() == Oth.Table.get_allocator()) {
+            take_table(Oth);
+            return;
+        }
+        presize(size() + Oth.size());
+        try {
+            for_each_bucket(Oth, [this, &Oth](size_t, bucket_type& Bucket) {
+                Oth.Sz -= Oth.compact_bucket(Bucket, [this, &Oth](slot_type& Slot) { return !move_absent(Slot, Oth); });
+            });
+        } catch (...) {
+            recount();
+            Oth.recount();
+            throw;
+        }
+        Oth.rebuild_occupancy();
+    }
+    // Moves items of Oth whose keys are absent into the map in O(size + Oth.size + Oth.buckets / 64) expected time, see merge(HashMap&).
+    void merge(HashMap&& Oth) {
+        merge(Oth);
+    }
+    // Erases item by key in O(1) amortized time and returns number of erased items. May invalidate iterators.
+    size_t erase(const KeyType& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by key of type K comparable with KeyType in O(1) amortized time and returns number of erased items.
+    // Enabled only for transparent Hash and KeyEqual. May invalidate iterators.
+    template<class K, class = TransparentKey<K>>
+    size_t erase(const K& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by iterator in O(1) time and returns iterator of the next item.
+    // The last item of the bucket takes place of the erased one. Unlike erase by key, never shrinks the table,
+    // so iterators of other buckets stay valid and erasing while iterating visits every remaining item once.
+    iterator erase(iterator Pos) {
+        size_t i = Pos.GetFirst(), j = Pos.GetSecond();
+        del(i, j);
+        return get_next_iterator(i, j);
+    }
+    // Erases items in range [First, Last) in O(distance + buckets in range) time and returns iterator of the item after them.
+    // Order of remaining items is kept. Never shrinks the table.
+    iterator erase(iterator First, iterator Last) {
+        size_t i = First.GetFirst(), j = First.GetSecond();
+        size_t LastBucket = Last.GetFirst();
+        for (; i < LastBucket; ++i, j = 0) {
+            Sz -= Table[i].size() - j;
+            Table[i].erase(Table[i].begin() + j, Table[i].end());
+            if (Table[i].empty()) {
+                mark_empty(i);
+            }
+        }
+        if (i != Table.size()) {
+            Sz -= Last.GetSecond() - j;
+            Table[i].erase(Table[i].begin() + j, Table[i].begin() + Last.GetSecond());
+            if (Table[i].empty()) {
+                mark_empty(i);
+            }
+        }
+        return get_next_iterator(i, j);
+    }
+    // Erases every item for which Pred returns true in one pass over occupied buckets in O(size + buckets / 64) time,
+    // then shrinks table once if it became sparse. Returns number of erased items. Order of remaining items is kept.
+    // If Pred throws, items it was not called for are kept. May invalidate iterators.
+    template<class Predicate>
+    size_t erase_if(Predicate Pred) {
+        size_t n = Sz;
+        try {
+            for_each_bucket(*this, [this, &Pred](size_t, bucket_type& Bucket) {
+                Sz -= compact_bucket(Bucket, [&Pred](slot_type& Slot) { return !Pred(Slot.Value); });
+            });
+        } catch (...) {
+            recount();
+            throw;
+        }
+        rebuild_occupancy();
+        if (is_sparse()) {
+            rebalance(size());
+        }
+        return n - Sz;
+    }
+    // Returns iterator of item by key in O(bucket size). If hash function is good, works in O(1) expected time.
+    iterator find(const KeyType& Key) {
+        auto Pos = find_position(Key);
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns constant iterator of item by key in O(bucket size). If hash function is good, works in O(1) expected time.
+    const_iterator find(const KeyType& Key) const {
+        auto Pos = find_position(Key);
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns iterator of item by key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    iterator find(const K& Key) {
+        auto Pos = find_position(Key);
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns constant iterator of item by key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const_iterator find(const K& Key) const {
+        auto Pos = find_position(Key);
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns iterator of item by key with hash function value KeyHash computed by the caller in O(1) expected time.
+    iterator find(const KeyType& Key, size_t KeyHash) {
+        auto Pos = find_position(Key, caller_hash(Key, KeyHash));
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns constant iterator of item by key with hash function value KeyHash computed by the caller in O(1) expected time.
+    const_iterator find(const KeyType& Key, size_t KeyHash) const {
+        auto Pos = find_position(Key, caller_hash(Key, KeyHash));
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns iterator of item by key of type K with hash function value KeyHash computed by the caller in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    iterator find(const K& Key, size_t KeyHash) {
+        auto Pos = find_position(Key, caller_hash(Key, KeyHash));
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns constant iterator of item by key of type K with hash function value KeyHash computed by the caller in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const_iterator find(const K& Key, size_t KeyHash) const {
+        auto Pos = find_position(Key, caller_hash(Key, KeyHash));
+        return get_iterator(Pos.first, Pos.second);
+    }
+    // Returns number of items with key in O(1) expected time.
+    size_t count(const KeyType& Key) const {
+        return find_position(Key).first != Table.size();
+    }
+    // Returns number of items with key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    size_t count(const K& Key) const {
+        return find_position(Key).first != Table.size();
+    }
+    // Returns true if an item with key is stored in O(1) expected time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns true if an item with key of type K comparable with KeyType is stored in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    bool contains(const K& Key) const {
+        return count(Key) != 0;
+    }
+    // Writes iterators of items by keys of range [first, last) to out in key order and returns the end of output.
+    // Keys are looked up in groups of BatchSize: hashes of a group are computed and its buckets prefetched first,
+    // so cache misses of different keys overlap. Works in O(1) expected time per key. KeyIterator must be forward.
+    template<class KeyIterator, class OutIterator>
+    OutIterator find_batch(KeyIterator first, KeyIterator last, OutIterator out) {
+        lookup_batch(first, last, [this, &out](size_t i, size_t j) { *out++ = get_iterator(i, j); });
+        return out;
+    }
+    // Writes constant iterators of items by keys of range [first, last) to out in key order and returns the end of output.
+    // Works in O(1) expected time per key, see find_batch().
+    template<class KeyIterator, class OutIterator>
+    OutIterator find_batch(KeyIterator first, KeyIterator last, OutIterator out) const {
+        lookup_batch(first, last, [this, &out](size_t i, size_t j) { *out++ = get_iterator(i, j); });
+        return out;
+    }
+    // Writes to out whether items by keys of range [first, last) are stored, in key order, and returns the end of output.
+    // Works in O(1) expected time per key, see find_batch().
+    template<class KeyIterator, class OutIterator>
+    OutIterator contains_batch(KeyIterator first, KeyIterator last, OutIterator out) const {
+        lookup_batch(first, last, [this, &out](size_t i, size_t) { *out++ = i != Table.size(); });
+        return out;
+    }
+    // Calls f with every item in O(size + buckets / 64) time. Sweeps words of the occupancy bitmap and item arrays of
+    // occupied buckets in memory order, without the per-item bucket checks of iterators. f must not insert or erase items.
+    template<class F>
+    void for_each(F&& f) {
+        for_each_bucket(*this, [&f](size_t, bucket_type& Bucket) {
+            for (slot_type& Slot : Bucket) {
+                f(Slot.Value);
+            }
+        });
+    }
+    // Calls f with every constant item in O(size + buckets / 64) time, see for_each().
+    template<class F>
+    void for_each(F&& f) const {
+        for_each_bucket(*this, [&f](size_t, const bucket_type& Bucket) {
+            for (const slot_type& Slot : Bucket) {
+                f(Slot.Value);
+            }
+        });
+    }
+    // Clears table and forgets size reserved by rehash() and reserve() in O(size + buckets) time. Frees buckets without allocating.
+    void clear() {
+        Sz = 0;
+        MinBucketCount = 0;
+        Table.clear();
+        initialize();
+    }
+    // Assigns *this to Oth. Copies buckets of Oth as they are with the allocator of *this, without calling the hash function.
+    // Works in O(Oth.size + Oth.buckets + *this.size) time. If an exception is thrown, there are no changes in the container.
+    HashMap& operator=(const HashMap& Oth) {
+        if (this != &Oth) {
+            table_type NewTable(Oth.Table, Table.get_allocator());
+            occupancy_type NewOccupied(Oth.Occupied, Occupied.get_allocator());
+            HashFunction = Oth.HashFunction;
+            Equal = Oth.Equal;
+            Growth = Oth.Growth;
+            Table.swap(NewTable);
+            Occupied.swap(NewOccupied);
+            FirstOccupied = Oth.FirstOccupied;
+            Sz = Oth.Sz;
+            MaxLoadFactor = Oth.MaxLoadFactor;
+            MinBucketCount = Oth.MinBucketCount;
+            Seed = Oth.Seed;
+            Keyed = Oth.Keyed;
+            FloodLimitShift = Oth.FloodLimitShift;
+#ifdef HASH_MAP_STATS
+            Counters = Oth.Counters;
+#endif
+        }
+        return *this;
+    }
+    // Moves Oth to *this in O(*this.size + *this.buckets) time. Oth is left empty.
+    HashMap& operator=(HashMap&& Oth) noexcept {
+        if (this != &Oth) {
+            clear();
+            swap(Oth);
+        }
+        return *this;
+    }
+    // Returns item by key in O(1) amortized time. If no items stored by this key, creates a new item.
+    ValueType& operator[](const KeyType& Key) {
+        return try_emplace(Key).first->second;
+    }
+    // Returns item by key in O(1) amortized time. If no items stored by this key, creates a new item from moved key.
+    ValueType& operator[](KeyType&& Key) {
+        return try_emplace(std::move(Key)).first->second;
+    }
+    // Returns item by key in O(1) time. If no items stored by this key, throws out of range exception. If an exception is thrown, there are no changes in the container.
+    const ValueType& at(const KeyType& Key) const {
+        return get_value(Key);
+    }
+    // Returns item by key of type K comparable with KeyType in O(1) time. If no items stored by this key, throws out of range exception.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const ValueType& at(const K& Key) const {
+        return get_value(Key);
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Sz;
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return Sz == 0;
+    }
+    // Swaps contents with Oth in O(1) time. Invalidates iterators of both containers.
+    void swap(HashMap& Oth) noexcept {
+        std::swap(HashFunction, Oth.HashFunction);
+        std::swap(Equal, Oth.Equal);
+        std::swap(Growth, Oth.Growth);
+        Table.swap(Oth.Table);
+        Occupied.swap(Oth.Occupied);
+        std::swap(FirstOccupied, Oth.FirstOccupied);
+        std::swap(Sz, Oth.Sz);
+        std::swap(MaxLoadFactor, Oth.MaxLoadFactor);
+        std::swap(MinBucketCount, Oth.MinBucketCount);
+        std::swap(Seed, Oth.Seed);
+        std::swap(Keyed, Oth.Keyed);
+        std::swap(FloodLimitShift, Oth.FloodLimitShift);
+#ifdef HASH_MAP_STATS
+        std::swap(Counters, Oth.Counters);
+#endif
+    }
+    // Returns number of buckets in O(1) time.
+    size_t bucket_count() const {
+        return Table.size();
+    }
+    // Returns statistics of chain lengths, collisions and memory in O(size log size + buckets) time,
+    // and event counters if HASH_MAP_STATS is defined.
+    HashMapStats stats() const {
+        HashMapStats Stats;
+        Stats.Size = Sz;
+        Stats.BucketCount = Table.size();
+        Stats.AllocatedBytes = Table.capacity() * sizeof(bucket_type) + Occupied.capacity() * sizeof(uint64_t);
+        std::vector<size_t> Hashes;
+        for (const bucket_type& Bucket : Table) {
+            size_t k = Bucket.size();
+            if (k >= Stats.ChainLengths.size()) {
+                Stats.ChainLengths.resize(k + 1);
+            }
+            ++Stats.ChainLengths[k];
+            Stats.OccupiedBuckets += k != 0;
+            Stats.MaxChainLength = std::max(Stats.MaxChainLength, k);
+            Stats.BucketCollisions += k != 0 ? k - 1 : 0;
+            Stats.SuccessfulProbes += k != 0 ? k * (k - 1) / 2 : 0;
+            Stats.AllocatedBytes += Bucket.capacity() * sizeof(slot_type);
+            if (k > 1) {
+                Hashes.clear();
+                for (const slot_type& Slot : Bucket) {
+                    Hashes.push_back(hash_of(Slot));
+                }
+                std::sort(Hashes.begin(), Hashes.end());
+                for (size_t j = 1; j != k; ++j) {
+                    Stats.HashCollisions += Hashes[j] == Hashes[j - 1];
+                }
+            }
+        }
+#ifdef HASH_MAP_STATS
+        Stats.Counters = Counters;
+#endif
+        return Stats;
+    }
+    // Returns average number of items per bucket in O(1) time.
+    float load_factor() const {
+        return Table.empty() ? 0 : static_cast<float>(size()) / bucket_count();
+    }
+    // Returns maximum average number of items per bucket in O(1) time.
+    float max_load_factor() const {
+        return MaxLoadFactor;
+    }
+    // Sets maximum average number of items per bucket. Rehashes table in O(size) time if it becomes dense or sparse.
+    // If the factor is not positive, throws invalid argument exception.
+    void max_load_factor(float f) {
+        if (!(f > 0)) {
+            throw std::invalid_argument("incorrect load factor");
+        }
+        MaxLoadFactor = f;
+        if (is_dense() || is_sparse()) {
+            rebalance(size());
+        }
+    }
+    // Sets number of buckets to at least n and at least enough for size() items in O(size + n) time.
+    // Table does not shrink below n buckets until clear() or rehash() with a smaller n. May invalidate iterators.
+    // Large tables are rehashed on several threads, see resize().
+    void rehash(size_t n) {
+        MinBucketCount = n;
+        size_t Buckets = Growth.bucket_count(std::max(n, min_bucket_count(size())));
+        if (Buckets != Table.size()) {
+            count_event(&HashMapCounters::ExplicitRehashes);
+            resize(Buckets, true);
+        }
+    }
+    // Sets number of buckets enough for n items in O(size + n) time, so that inserting them does not resize table.
+    // May invalidate iterators.
+    void reserve(size_t n) {
+        rehash(min_bucket_count(n));
+    }
+    // Inserts items of random access range [first, last) whose keys are absent, like inserting them one by one,
+    // on ThreadCount threads or, if it is zero, on as many as the hardware runs with at least ParallelGrain items each.
+    // Sizes table once, then every thread hashes its part of the range and sorts items by owner of their bucket range,
+    // and then every owner inserts its items in range order into its own buckets. Works in O(size + n / threads) time.
+    // Hash and KeyEqual must be safe to call from several threads. Allocators which are not thread safe, such as
+    // ArenaAllocator, can not serve several threads, so with them the items are inserted on the calling thread. May invalidate iterators.
+    template<class Iterator>
+    void parallel_insert(Iterator first, Iterator last, size_t ThreadCount = 0) {
+        static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>::value,
+                      "parallel_insert needs random access iterators");
+        size_t n = static_cast<size_t>(std::distance(first, last));
+        size_t t = ThreadCount != 0 ? ThreadCount : parallel_thread_count(n);
+        // Owner threads allocate bucket arrays at the same time.
+        if (t <= 1 || !IsThreadSafeAllocator<Allocator>::value) {
+            for (auto i = first; i != last; ++i) {
+                insert(*i);
+            }
+            return;
+        }
+        presize(size() + n, true);
+        size_t b = Table.size();
+        std::vector<std::vector<std::pair<size_t, size_t>>> Parts(t * t);
+        run_on_threads(t, [&](size_t Chunk) {
+            for (size_t i = n * Chunk / t; i != n * (Chunk + 1) / t; ++i) {
+                size_t h = hash_key(first[i].first);
+                Parts[Chunk * t + partition(index_of(h, b), b, t)].emplace_back(i, h);
+            }
+        });
+        std::vector<size_t> Added(t);
+        auto Count = [&Added, this]() {
+            for (size_t a : Added) {
+                Sz += a;
+            }
+        };
+        try {
+            run_on_threads(t, [&](size_t Owner) {
+                for (size_t Chunk = 0; Chunk != t; ++Chunk) {
+                    for (auto& Part : Parts[Chunk * t + Owner]) {
+                        bucket_type& Bucket = Table[index_of(Part.second, b)];
+                        if (find_in_bucket(Bucket, first[Part.first].first, Part.second) == Bucket.size()) {
+                            Bucket.emplace_back(std::in_place, first[Part.first]);
+                            Bucket.back().set_hash(Part.second);
+                            ++Added[Owner];
+                        }
+                    }
+                }
+            });
+        } catch (...) {
+            Count();
+            rebuild_occupancy();
+            throw;
+        }
+        Count();
+        rebuild_occupancy();
+    }
+#ifdef HASH_MAP_MMAP
+    typedef MappedHashMap<KeyType, ValueType, Hash, KeyEqual> mapped_view_type;
+    // Writes every item to file Path in the format of MappedHashMapHeader in O(size) time, so that open_mapped() can
+    // read it without deserialization. The file is written under a temporary name and renamed, so readers of an older
+    // file at Path keep their mapping. Throws system error exception on failure. Keys and values must be trivially copyable.
+    void save(const std::string& Path) const {
+        static_assert(std::is_trivially_copyable<KeyType>::value && std::is_trivially_copyable<ValueType>::value,
+                      "saved maps need trivially copyable keys and values");
+        typedef typename mapped_view_type::value_type item_type;
+        MappedHashMapHeader Header = MappedHashMapHeader::make<item_type>(Sz, sizeof(KeyType), sizeof(ValueType));
+        write_mapped_file(Path, Header.FileSize, [this, &Header](unsigned char* Data) {
+            std::memcpy(Data, &Header, sizeof(Header));
+            uint64_t* Offsets = reinterpret_cast<uint64_t*>(Data + Header.BucketsOffset);
+            unsigned char* Items = Data + Header.ItemsOffset;
+            size_t Mask = Header.BucketCount - 1;
+            // The file is read with Hash, so keyed hashes of a flooded map are not used.
+            auto BucketOf = [this, Mask](const slot_type& Slot) {
+                return MurmurHashMixer()(Keyed ? HashFunction(Slot.Value.first) : hash_of(Slot)) & Mask;
+            };
+            // Counting sort by bucket: Offsets[b + 1] counts items of bucket b, prefix sums turn Offsets[b] into
+            // the place of the next item of bucket b, and after scattering Offsets[b] is where bucket b + 1 starts.
+            for (const bucket_type& Bucket : Table) {
+                for (const slot_type& Slot : Bucket) {
+                    ++Offsets[BucketOf(Slot) + 1];
+                }
+            }
+            for (size_t b = 1; b <= Header.BucketCount; ++b) {
+                Offsets[b] += Offsets[b - 1];
+            }
+            for (const bucket_type& Bucket : Table) {
+                for (const slot_type& Slot : Bucket) {
+                    item_type Item;
+                    std::memset(static_cast<void*>(&Item), 0, sizeof(Item));
+                    std::memcpy(static_cast<void*>(&Item.first), &Slot.Value.first, sizeof(KeyType));
+                    std::memcpy(static_cast<void*>(&Item.second), &Slot.Value.second, sizeof(ValueType));
+                    std::memcpy(Items + Offsets[BucketOf(Slot)]++ * sizeof(item_type), &Item, sizeof(Item));
+                }
+            }
+            std::memmove(Offsets + 1, Offsets, Header.BucketCount * sizeof(uint64_t));
+            Offsets[0] = 0;
+        });
+    }
+    // Returns read-only view of a map file written by save() in O(1) time. Items are read from the mapped file on access.
+    // Throws system error exception if the file can not be mapped and runtime error exception if it is not a map file.
+    static mapped_view_type open_mapped(const std::string& Path, const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual()) {
+        return mapped_view_type(Path, HashFunction, Equal);
+    }
+#endif
+    // Returns immutable copy of the map with minimal perfect hashing of its keys in O(size log size) expected time.
+    // Throws invalid argument exception if hashes of different keys are equal.
+    FrozenHashMap<KeyType, ValueType, Hash, KeyEqual, Allocator> freeze() const {
+        return FrozenHashMap<KeyType, ValueType, Hash, KeyEqual, Allocator>(begin(), end(), HashFunction, Equal, get_allocator());
+    }
+
+  private:
+    // Returns number of threads worth running on n items: as many as the hardware runs, with at least ParallelGrain items each.
+    static size_t parallel_thread_count(size_t n) {
+        return std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), n / ParallelGrain));
+    }
+    // Returns which of t threads owns bucket i of b in parallel insertion and resize. Every thread owns a contiguous range.
+    static size_t partition(size_t i, size_t b, size_t t) {
+        return i * t / b;
+    }
+    // Returns number of item by key with hash h in Bucket or bucket size if there is no such item in O(bucket size) time.
+    // Stored hashes are compared before keys.
+    template<class K>
+    size_t find_in_bucket(const bucket_type& Bucket, const K& Key, size_t h) const {
+        for (size_t j = 0; j != Bucket.size(); ++j) {
+            if (Bucket[j].hash_matches(h) && Equal(Bucket[j].Value.first, Key)) {
+                return j;
+            }
+        }
+        return Bucket.size();
+    }
+    // Returns hash of item in Slot in O(1) time: the stored one or, without stored hashes, hash of its key.
+    size_t hash_of(const slot_type& Slot) const {
+        if constexpr (slot_type::Stored) {
+            return Slot.hash();
+        } else {
+            return hash_key(Slot.Value.first);
+        }
+    }
+    // Returns hash of Key in O(1) time: hash function value, or SipHash keyed by the seed once keys flooded the table.
+    template<class K>
+    size_t hash_key(const K& Key) const {
+        if constexpr (KeyedFallback) {
+            if (Keyed) {
+                return SipHash(MurmurHashMixer()(Seed ^ 0x736970686173686bULL), MurmurHashMixer()(Seed ^ 0x6b65796564686173ULL))(Key);
+            }
+        }
+        return HashFunction(Key);
+    }
+    // Returns hash of Key given hash function value KeyHash computed by the caller in O(1) time. Once the map switched
+    // to keyed hashing, the caller's value no longer locates the key, so the key is hashed again.
+    template<class K>
+    size_t caller_hash(const K& Key, size_t KeyHash) const {
+        return Keyed ? hash_key(Key) : KeyHash;
+    }
+    // Returns bucket of hash h in table of n buckets in O(1) time. The seed is xored into the hash and mixed by
+    // FibonacciHashMixer before the growth policy reduces or mixes it, so that keys with different hashes can not be
+    // sent to one bucket without knowing the seed. Fibonacci mixing leaves low bits of equal-low-bit hashes equal,
+    // so with IdentityHashMixer power-of-two policies keep such collisions; defend() turns to keyed hashing then.
+    size_t index_of(size_t h, size_t n) const {
+        return Growth.index(FibonacciHashMixer()(h ^ Seed), n);
+    }
+    // Returns length of bucket chains treated as flooding with current max load factor in O(1) time.
+    size_t flood_chain_length() const {
+        return (FloodChainLength << FloodLimitShift) + static_cast<size_t>(4 * MaxLoadFactor);
+    }
+    // Handles bucket of hash h, whose chain grew to flood_chain_length(), in O(size + buckets) time. If most items of
+    // the chain have different hashes, they only share a bucket, so the table is rehashed with a new random seed.
+    // If most hashes are equal or the new seed leaves the chain as long, Hash is weak or attacked and only another hash
+    // function helps: with KeyedFallback the table switches to SipHash. Otherwise nothing helps and the limit doubles,
+    // so that such a chain costs O(size) work only O(log size) times.
+    void defend(size_t h) {
+        std::vector<size_t> Hashes;
+        for (const slot_type& Slot : Table[index_of(h, Table.size())]) {
+            Hashes.push_back(hash_of(Slot));
+        }
+        std::sort(Hashes.begin(), Hashes.end());
+        size_t Repeated = 0;
+        for (size_t j = 1; j < Hashes.size(); ++j) {
+            Repeated += Hashes[j] == Hashes[j - 1];
+        }
+        if (2 * Repeated < Hashes.size()) {
+            count_event(&HashMapCounters::FloodReseeds);
+            reseed_table(hash_map_random_seed(), Keyed);
+            if (Table[index_of(h, Table.size())].size() < flood_chain_length()) {
+                return;
+            }
+        }
+        if (KeyedFallback && !Keyed) {
+            count_event(&HashMapCounters::FloodReseeds);
+            reseed_table(hash_map_random_seed(), true);
+        } else {
+            ++FloodLimitShift;
+        }
+    }
+    // Sets seed to NewSeed and keyed hashing to NewKeyed and rehashes table in O(size + buckets) time.
+    void reseed_table(size_t NewSeed, bool NewKeyed) {
+        bool Rehash = NewKeyed != Keyed;
+        Seed = NewSeed;
+        Keyed = NewKeyed;
+        if constexpr (slot_type::Stored) {
+            if (Rehash) {
+                for (bucket_type& Bucket : Table) {
+                    for (slot_type& Slot : Bucket) {
+                        Slot.set_hash(hash_key(Slot.Value.first));
+                    }
+                }
+            }
+        }
+        if (!Table.empty()) {
+            resize(Table.size());
+        }
+    }
+    // Looks up keys of range [first, last) in groups of BatchSize and calls f with bucket and item numbers of every item
+    // in key order, or with bucket count and zero for absent keys. Bucket headers of a group are prefetched while hashing,
+    // then item arrays of the group, then the group is resolved. Works in O(1) expected time per key.
+    template<class KeyIterator, class F>
+    void lookup_batch(KeyIterator first, KeyIterator last, F&& f) const {
+        if (empty()) {
+            for (; first != last; ++first) {
+                f(Table.size(), 0);
+            }
+            return;
+        }
+        size_t Hashes[BatchSize], Buckets[BatchSize];
+        while (first != last) {
+            KeyIterator Group = first;
+            size_t n = 0;
+            for (; n != BatchSize && first != last; ++n, ++first) {
+                Hashes[n] = hash_key(*first);
+                Buckets[n] = index_of(Hashes[n], Table.size());
+                prefetch(&Table[Buckets[n]]);
+            }
+            for (size_t k = 0; k != n; ++k) {
+                prefetch(Table[Buckets[k]].data());
+            }
+            for (size_t k = 0; k != n; ++k, ++Group) {
+                size_t j = find_in_bucket(Table[Buckets[k]], *Group, Hashes[k]);
+                if (j == Table[Buckets[k]].size()) {
+                    f(Table.size(), 0);
+                } else {
+                    f(Buckets[k], j);
+                }
+            }
+        }
+    }
+    // Adds n to Counter of stats() in O(1) time if HASH_MAP_STATS is defined, otherwise does nothing.
+    void count_event([[maybe_unused]] size_t HashMapCounters::*Counter, [[maybe_unused]] size_t n = 1) {
+#ifdef HASH_MAP_STATS
+        Counters.*Counter += n;
+#endif
+    }
+    // Makes table without buckets in O(1) time, so that empty maps do not allocate. The first insertion adds a bucket.
+    void initialize() {
+        rebuild_occupancy();
+    }
+    // Adds the first bucket to a table without buckets in O(1) time.
+    void ensure_bucket() {
+        if (Table.empty()) {
+            Table.resize(1);
+            rebuild_occupancy();
+        }
+    }
+    // Marks bucket i as holding items in O(1) time.
+    void mark_occupied(size_t i) {
+        Occupied[i / 64] |= uint64_t(1) << (i % 64);
+        FirstOccupied = std::min(FirstOccupied, i);
+    }
+    // Marks bucket i as empty in O(1) time, or in O(distance to the next occupied bucket / 64) if it was the first one.
+    void mark_empty(size_t i) {
+        Occupied[i / 64] &= ~(uint64_t(1) << (i % 64));
+        if (i == FirstOccupied) {
+            FirstOccupied = find_next_set_bit(Occupied.data(), Table.size(), i + 1);
+        }
+    }
+    // Calls f with number and reference of every occupied bucket of map m, constant or not, in increasing order
+    // in O(occupied + buckets / 64) time. Buckets are taken from a copy of each bitmap word, so f may empty the bucket
+    // it is called with.
+    template<class MapType, class F>
+    static void for_each_bucket(MapType& m, F&& f) {
+        for (size_t w = 0; w != m.Occupied.size(); ++w) {
+            for (uint64_t Word = m.Occupied[w]; Word != 0; Word &= Word - 1) {
+                size_t i = w * 64 + count_trailing_zeros(Word);
+                f(i, m.Table[i]);
+            }
+        }
+    }
+    // Keeps items of Bucket for which Keep returns true in their order and erases the rest in O(bucket size) time.
+    // Returns number of erased items. If Keep throws, the item it was called for and the following ones are kept.
+    // Does not update size and occupancy.
+    template<class F>
+    size_t compact_bucket(bucket_type& Bucket, F&& Keep) {
+        size_t k = 0, j = 0, n = Bucket.size();
+        auto Shrink = [&]() {
+            for (; j != n; ++j, ++k) {
+                if (k != j) {
+                    Bucket[k] = std::move(Bucket[j]);
+                }
+            }
+            Bucket.erase(Bucket.begin() + k, Bucket.end());
+        };
+        try {
+            for (; j != n; ++j) {
+                if (Keep(Bucket[j])) {
+                    if (k != j) {
+                        Bucket[k] = std::move(Bucket[j]);
+                    }
+                    ++k;
+                }
+            }
+        } catch (...) {
+            Shrink();
+            throw;
+        }
+        Shrink();
+        return n - k;
+    }
+    // Moves item of Slot of Oth to the end of its bucket and returns true if its key is absent, otherwise returns false.
+    // Works in O(bucket size) time. Table must already fit the item. The hash stored by Oth is reused if both maps
+    // hash keys by the same stateless Hash.
+    bool move_absent(slot_type& Slot, const HashMap& Oth) {
+        size_t h;
+        if constexpr (slot_type::Stored && std::is_empty<Hash>::value) {
+            h = Keyed || Oth.Keyed ? hash_key(Slot.Value.first) : Slot.hash();
+        } else {
+            h = hash_key(Slot.Value.first);
+        }
+        size_t i = index_of(h, Table.size());
+        if (find_in_bucket(Table[i], Slot.Value.first, h) != Table[i].size()) {
+            return false;
+        }
+        if (Table[i].size() >= flood_chain_length()) {
+            defend(h);
+            h = hash_key(Slot.Value.first);
+            i = index_of(h, Table.size());
+        }
+        Table[i].push_back(std::move(Slot));
+        Table[i].back().set_hash(h);
+        mark_occupied(i);
+        ++Sz;
+        return true;
+    }
+    // Takes table of Oth, leaving it the table of the map, in O(1) time, or in O(size) if max load factors differ.
+    // The seed and keyed hashing travel with the table they index.
+    void take_table(HashMap& Oth) {
+        Table.swap(Oth.Table);
+        Occupied.swap(Oth.Occupied);
+        std::swap(Growth, Oth.Growth);
+        std::swap(FirstOccupied, Oth.FirstOccupied);
+        std::swap(Sz, Oth.Sz);
+        std::swap(Seed, Oth.Seed);
+        std::swap(Keyed, Oth.Keyed);
+        std::swap(FloodLimitShift, Oth.FloodLimitShift);
+        if (is_dense() || is_sparse()) {
+            rebalance(size());
+        }
+    }
+    // Recomputes size and occupancy from the table in O(buckets) time, after a bulk operation was interrupted.
+    void recount() {
+        Sz = 0;
+        for (const bucket_type& Bucket : Table) {
+            Sz += Bucket.size();
+        }
+        rebuild_occupancy();
+    }
+    // Rebuilds the bitmap of occupied buckets and the first occupied bucket from the table in O(buckets) time.
+    void rebuild_occupancy() {
+        Occupied.assign((Table.size() + 63) / 64, 0);
+        for (size_t i = 0; i != Table.size(); ++i) {
+            if (!Table[i].empty()) {
+                Occupied[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+        FirstOccupied = find_next_set_bit(Occupied.data(), Table.size(), 0);
+    }
+    // Returns bucket and item numbers of item by key, or bucket count and zero if there is no such item.
+    // Works in O(bucket size) time.
+    template<class K>
+    std::pair<size_t, size_t> find_position(const K& Key) const {
+        if (empty()) {
+            return {Table.size(), 0};
+        }
+        return find_position(Key, hash_key(Key));
+    }
+    // Returns bucket and item numbers of item by key with hash function value h, or bucket count and zero if there
+    // is no such item. Works in O(bucket size) time.
+    template<class K>
+    std::pair<size_t, size_t> find_position(const K& Key, size_t h) const {
+        if (empty()) {
+            return {Table.size(), 0};
+        }
+        size_t i = index_of(h, Table.size());
+        size_t j = find_in_bucket(Table[i], Key, h);
+        if (j == Table[i].size()) {
+            return {Table.size(), 0};
+        }
+        return {i, j};
+    }
+    // Returns item by key or throws out of range exception if there is no such item. Works in O(bucket size) time.
+    template<class K>
+    const ValueType& get_value(const K& Key) const {
+        auto Pos = find_position(Key);
+        if (Pos.first == Table.size()) {
+            throw std::out_of_range("incorrect key");
+        }
+        return Table[Pos.first][Pos.second].Value.second;
+    }
+    // Erases item by key and shrinks table if it becomes sparse. Returns number of erased items. Works in O(1) amortized time.
+    template<class K>
+    size_t erase_key(const K& Key) {
+        auto Pos = find_position(Key);
+        if (Pos.first == Table.size()) {
+            return 0;
+        }
+        del(Pos.first, Pos.second);
+        if (is_sparse()) {
+            rebalance(size());
+        }
+        return 1;
+    }
+    // Returns iterator for bucket of number f and item of number s in the bucket in O(1) time.
+    iterator get_iterator(size_t f = 0, size_t s = 0) {
+        return iterator(&Table, &Occupied, f, s);
+    }
+    // Returns constant iterator for bucket of number f and item of number s in the bucket in O(1) time.
+    const_iterator get_iterator(size_t f = 0, size_t s = 0) const {
+        return const_iterator(&Table, &Occupied, f, s);
+    }
+    // Returns iterator of item number s in bucket f, or of the next item if bucket f has no such item.
+    // Skips empty buckets 64 at a time by the occupancy bitmap.
+    iterator get_next_iterator(size_t f, size_t s) {
+        if (f != Table.size() && s == Table[f].size()) {
+            f = find_next_set_bit(Occupied.data(), Table.size(), f + 1);
+            s = 0;
+        }
+        return get_iterator(f, s);
+    }
+    // Returns iterator of item by key and true, or iterator of the place at the end of the key bucket where an item
+    // with this key should be constructed and false. Works in O(bucket size) time, hash function is called once
+    // and h is set to its value. If one more item would make table dense, the table grows beforehand, so the returned place stays valid.
+    // If the bucket of the key is a chain too long for chance, the table is reseeded beforehand, see defend().
+    std::pair<iterator, bool> find_or_prepare_insert(const KeyType& Key, size_t& h) {
+        h = hash_key(Key);
+        ensure_bucket();
+        size_t i = index_of(h, Table.size());
+        size_t j = find_in_bucket(Table[i], Key, h);
+        if (j != Table[i].size()) {
+            return {get_iterator(i, j), true};
+        }
+        if (is_full()) {
+            rebalance(size() + 1);
+            i = index_of(h, Table.size());
+        }
+        if (Table[i].size() >= flood_chain_length()) {
+            defend(h);
+            h = hash_key(Key);
+            i = index_of(h, Table.size());
+        }
+        return {get_iterator(i, Table[i].size()), false};
+    }
+    // Finds key and if it is absent, constructs item from args at the end of its bucket in O(1) amortized time.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_key(const KeyType& Key, Args&&... args) {
+        size_t h;
+        auto Place = find_or_prepare_insert(Key, h);
+        if (Place.second) {
+            return {Place.first, false};
+        }
+        bucket_type& Bucket = Table[Place.first.GetFirst()];
+        Bucket.emplace_back(std::in_place, std::forward<Args>(args)...);
+        Bucket.back().set_hash(h);
+        if (Bucket.size() == 1) {
+            mark_occupied(Place.first.GetFirst());
+        }
+        ++Sz;
+        return {Place.first, true};
+    }
+    // Emplaces item constructed from key and value, looking the key up before construction.
+    template<class K, class V>
+    std::pair<iterator, bool> emplace_decomposed(K&& k, V&& v) {
+        if constexpr (std::is_same<typename std::decay<K>::type, KeyType>::value) {
+            return emplace_key(k, std::forward<K>(k), std::forward<V>(v));
+        } else {
+            KeyType Key(std::forward<K>(k));
+            return emplace_key(Key, std::move(Key), std::forward<V>(v));
+        }
+    }
+    // Emplaces item constructed from members of pair Item.
+    template<class P, class = decltype(std::declval<P&>().first)>
+    std::pair<iterator, bool> emplace_decomposed(P&& Item) {
+        return emplace_decomposed(std::forward<P>(Item).first, std::forward<P>(Item).second);
+    }
+    // Emplaces item constructed from arbitrary arguments through a temporary pair.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_decomposed(Args&&... args) {
+        std::pair<KeyType, ValueType> Item(std::forward<Args>(args)...);
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Erases item number j of bucket i in O(1) time by moving the last item of the bucket in its place.
+    void del(size_t i, size_t j) {
+        bucket_type& Bucket = Table[i];
+        if (j + 1 != Bucket.size()) {
+            Bucket[j] = std::move(Bucket.back());
+        }
+        Bucket.pop_back();
+        if (Bucket.empty()) {
+            mark_empty(i);
+        }
+        --Sz;
+    }
+    // Returns true if number of items stored is more than product of max load factor and buckets number.
+    bool is_dense() const {
+        return size() > Table.size() * MaxLoadFactor;
+    }
+    // Returns true if number of items stored is less than product of shrink factor, max load factor and buckets number.
+    // Table reserved by rehash() is never sparse.
+    bool is_sparse() const {
+        return Table.size() > std::max<size_t>(MinBucketCount, 1) && size() < Table.size() * MaxLoadFactor * GrowthPolicy::ShrinkFactor;
+    }
+    // Returns true if one more item would make table dense.
+    bool is_full() const {
+        return size() + 1 > Table.size() * MaxLoadFactor;
+    }
+    // Resizes table in O(size) time, so that load factor with n items becomes about max_load_factor() / ResizeFactor.
+    // With incremental growth policy adds or removes buckets one by one instead, until the table is neither dense
+    // nor sparse with n items. That takes O(1) amortized time per inserted or erased item.
+    void rebalance(size_t n) {
+        if constexpr (GrowthPolicy::Incremental) {
+            while (n > Table.size() * MaxLoadFactor) {
+                count_event(&HashMapCounters::GrowRehashes);
+                split_bucket();
+            }
+            while (Table.size() > std::max<size_t>(MinBucketCount, 1) && n < (Table.size() - 1) * MaxLoadFactor * GrowthPolicy::ShrinkFactor) {
+                count_event(&HashMapCounters::ShrinkRehashes);
+                merge_bucket();
+            }
+        } else {
+            size_t Buckets = Growth.bucket_count(std::max(MinBucketCount, static_cast<size_t>(n * GrowthPolicy::ResizeFactor / MaxLoadFactor)));
+            if (Buckets != Table.size()) {
+                count_event(Buckets > Table.size() ? &HashMapCounters::GrowRehashes : &HashMapCounters::ShrinkRehashes);
+                resize(Buckets);
+            }
+        }
+    }
+    // Adds one bucket and moves to it items of the bucket it splits in O(bucket size) time. For incremental growth policies.
+    void split_bucket() {
+        size_t n = Table.size();
+        size_t s = n - highest_power_of_two(n);
+        Table.emplace_back();
+        if (n % 64 == 0) {
+            Occupied.push_back(0);
+        }
+        bucket_type& From = Table[s];
+        for (size_t j = 0; j < From.size(); ) {
+            if (index_of(hash_of(From[j]), n + 1) != s) {
+                Table[n].push_back(std::move(From[j]));
+                if (j + 1 != From.size()) {
+                    From[j] = std::move(From.back());
+                }
+                From.pop_back();
+            } else {
+                ++j;
+            }
+        }
+        if (!Table[n].empty()) {
+            mark_occupied(n);
+            if (From.empty()) {
+                mark_empty(s);
+            }
+        }
+    }
+    // Removes the last bucket and moves its items to the bucket it was split from in O(bucket size) time.
+    // For incremental growth policies, table must have at least two buckets.
+    void merge_bucket() {
+        size_t n = Table.size() - 1;
+        size_t s = n - highest_power_of_two(n);
+        bucket_type& To = Table[s];
+        for (auto& Item : Table[n]) {
+            To.push_back(std::move(Item));
+        }
+        if (!Table[n].empty()) {
+            mark_occupied(s);
+        }
+        Occupied[n / 64] &= ~(uint64_t(1) << (n % 64));
+        Table.pop_back();
+        if (n % 64 == 0) {
+            Occupied.pop_back();
+        }
+    }
+    // Returns number of buckets needed to keep n items within max load factor in O(1) time.
+    size_t min_bucket_count(size_t n) const {
+        return static_cast<size_t>(std::ceil(n / MaxLoadFactor));
+    }
+    // Grows table to fit n items in O(size + n) time, on several threads if Parallel is true, see resize().
+    // Unlike reserve(), lets table shrink back after erases.
+    void presize(size_t n, bool Parallel = false) {
+        size_t Buckets = Growth.bucket_count(min_bucket_count(n));
+        if (Buckets > Table.size()) {
+            count_event(&HashMapCounters::ExplicitRehashes);
+            resize(Buckets, Parallel);
+        }
+    }
+    // Grows table to fit items of [first, last) range if its length is known without iterating, otherwise does nothing.
+    template<class Iterator>
+    void presize(Iterator first, Iterator last) {
+        if constexpr (std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>::value) {
+            presize(static_cast<size_t>(std::distance(first, last)));
+        }
+    }
+    // Changes number of buckets to n in O(size + n) time. Items are moved, not copied, and old buckets are freed
+    // as soon as they are emptied, one by one or, on several threads, chunk by chunk, so peak memory stays close to one table of items.
+    // If Parallel is true, large tables are resized on several threads, which call Hash at the same time, provided
+    // items move without exceptions and the allocator is stateless, so that threads may allocate buckets at the same time.
+    // Only explicit rehash(), reserve() and parallel_insert() ask for it, so growth on insertion never starts threads.
+    void resize(size_t n, bool Parallel = false) {
+        count_event(&HashMapCounters::RehashedItems, size());
+        table_type OldTable(std::max<size_t>(n, 1), Table.get_allocator());
+        Table.swap(OldTable);
+        if constexpr (std::is_nothrow_move_constructible<slot_type>::value && std::allocator_traits<Allocator>::is_always_equal::value) {
+            size_t t = Parallel ? parallel_thread_count(size()) : 1;
+            if (t > 1) {
+                parallel_move(OldTable, t);
+                rebuild_occupancy();
+                return;
+            }
+        }
+        for (auto& Bucket : OldTable) {
+            for (auto& Item : Bucket) {
+                Table[index_of(hash_of(Item), Table.size())].push_back(std::move(Item));
+            }
+            bucket_type(Bucket.get_allocator()).swap(Bucket);
+        }
+        rebuild_occupancy();
+    }
+    // Moves every item of OldTable into the table on t threads in O(size / t + buckets) time.
+    // Old buckets are split into ParallelChunks chunks per thread. Every thread first sorts items of its chunks by owner
+    // of their new buckets, then every owner moves the items it owns chunk by chunk, and the last owner to finish a chunk
+    // frees its old buckets, so at most a few chunks of old buckets are alive beside the new table.
+    void parallel_move(table_type& OldTable, size_t t) {
+        size_t b = Table.size();
+        size_t c = t * ParallelChunks;
+        std::vector<std::vector<std::pair<slot_type*, size_t>>> Parts(c * t);
+        run_on_threads(t, [&](size_t Thread) {
+            for (size_t Chunk = Thread; Chunk < c; Chunk += t) {
+                for (size_t i = OldTable.size() * Chunk / c; i != OldTable.size() * (Chunk + 1) / c; ++i) {
+                    for (auto& Item : OldTable[i]) {
+                        size_t Bucket = index_of(hash_of(Item), b);
+                        Parts[Chunk * t + partition(Bucket, b, t)].emplace_back(&Item, Bucket);
+                    }
+                }
+            }
+        });
+        // Number of owners done with every chunk.
+        std::vector<std::atomic<size_t>> Done(c);
+        run_on_threads(t, [&](size_t Owner) {
+            for (size_t Chunk = 0; Chunk != c; ++Chunk) {
+                for (auto& Part : Parts[Chunk * t + Owner]) {
+                    Table[Part.second].push_back(std::move(*Part.first));
+                }
+                std::vector<std::pair<slot_type*, size_t>>().swap(Parts[Chunk * t + Owner]);
+                if (Done[Chunk].fetch_add(1, std::memory_order_acq_rel) + 1 == t) {
+                    for (size_t i = OldTable.size() * Chunk / c; i != OldTable.size() * (Chunk + 1) / c; ++i) {
+                        bucket_type(OldTable[i].get_allocator()).swap(OldTable[i]);
+                    }
+                }
+            }
+        });
+    }
+    Hash HashFunction;
+    KeyEqual Equal;
+    GrowthPolicy Growth;
+    table_type Table;
+    // Bit i is set if bucket i holds items.
+    occupancy_type Occupied;
+    // Number of the first bucket holding items. Meaningless if the table is empty.
+    size_t FirstOccupied = 0;
+    size_t Sz = 0;
+    float MaxLoadFactor = DefaultMaxLoadFactor;
+    size_t MinBucketCount = 0;
+    size_t Seed = hash_map_random_seed();
+    // True once keys are hashed by SipHash instead of Hash, see defend().
+    bool Keyed = false;
+    // Flood chain length is doubled this many times, see defend().
+    uint8_t FloodLimitShift = 0;
+#ifdef HASH_MAP_STATS
+    HashMapCounters Counters;
+#endif
+};
+
+// Hash table iterator implemented by storing bucket and item numbers.
+// Skips empty buckets by the occupancy bitmap of the table, so iteration works in O(size + buckets / 64) time.
+template<class TableType, class BitmapType>
+class HashMapIterator {
+  public:
+    // Item type: table stores buckets of slots, each slot keeps one item.
+    typedef typename TableType::value_type::value_type::value_type ValueType;
+    // Default constructor.
+    HashMapIterator() {}
+    // Constructor by table, its occupancy bitmap, bucket number and item number.
+    HashMapIterator(TableType* t, const BitmapType* b, size_t f, size_t s) {
+        First = f;
+        Second = s;
+        Table = t;
+        Occupied = b;
+    }
+    // Returns true if iterator is equal to Oth in O(1) time.
+    bool operator==(const HashMapIterator &Oth) const {
+        return First == Oth.First && Second == Oth.Second && Table == Oth.Table;
+    }
+    // Returns true if iterator is not equal to Oth in O(1) time.
+    bool operator!=(const HashMapIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns bucket number in O(1) time.
+    size_t GetFirst() {
+        return First;
+    }
+    // Returns item number in bucket in O(1) time.
+    size_t GetSecond() {
+        return Second;
+    }
+    // Returns item object in O(1) time.
+    ValueType& operator*() {
+        return (*Table)[First][Second].Value;
+    }
+    // Returns constant item object in O(1) time.
+    ValueType operator*() const {
+        return (*Table)[First][Second].Value;
+    }
+    // Returns item reference in O(1) time.
+    ValueType* operator->() {
+        return &(*Table)[First][Second].Value;
+    }
+    // Returns constant item reference in O(1) time.
+    ValueType const* operator->() const {
+        return &(*Table)[First][Second].Value;
+    }
+    // Moves iterator to next item and returns it in O(1) expected time.
+    HashMapIterator operator++() {
+        ++Second;
+        if (Second >= (*Table)[First].size()) {
+            First = find_next_set_bit(Occupied->data(), Table->size(), First + 1);
+            Second = 0;
+        }
+        return *this;
+    }
+    // Moves iterator to next item and returns its previous state in O(1) expected time.
+    HashMapIterator operator++(int) {
+        HashMapIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    TableType* Table = nullptr;
+    const BitmapType* Occupied = nullptr;
+    size_t First = 0, Second = 0;
+};
+
+// Constant hash table iterator implemented by storing bucket and item numbers.
+// Skips empty buckets by the occupancy bitmap of the table, so iteration works in O(size + buckets / 64) time.
+template<class TableType, class BitmapType>
+class HashMapConstIterator {
+  public:
+    // Item type: table stores buckets of slots, each slot keeps one item.
+    typedef typename TableType::value_type::value_type::value_type ValueType;
+    // Default constructor.
+    HashMapConstIterator() {}
+    // Constructor by table, its occupancy bitmap, bucket number and item number.
+    HashMapConstIterator(const TableType* t, const BitmapType* b, size_t f, size_t s) {
+        First = f;
+        Second = s;
+        Table = t;
+        Occupied = b;
+    }
+    // Returns true if constant iterator is equal to Oth in O(1) time.
+    bool operator==(const HashMapConstIterator &Oth) const {
+        return First == Oth.First && Second == Oth.Second && Table == Oth.Table;
+    }
+    // Returns true if constant iterator is not equal to Oth in O(1) time.
+    bool operator!=(const HashMapConstIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns bucket number in O(1) time.
+    size_t GetFirst() {
+        return First;
+    }
+    // Returns item number in bucket in O(1) time.
+    size_t GetSecond() {
+        return Second;
+    }
+    // Returns constant item object in O(1) time.
+    ValueType operator*() const {
+        return (*Table)[First][Second].Value;
+    }
+    // Returns constant item reference in O(1) time.
+    ValueType const* operator->() const {
+        return &(*Table)[First][Second].Value;
+    }
+    // Moves constant iterator to next item and returns it in O(1) expected time.
+    HashMapConstIterator operator++() {
+        ++Second;
+        if (Second >= (*Table)[First].size()) {
+            First = find_next_set_bit(Occupied->data(), Table->size(), First + 1);
+            Second = 0;
+        }
+        return *this;
+    }
+    // Moves constant iterator to next item and returns its previous state in O(1) expected time.
+    HashMapConstIterator operator++(int) {
+        HashMapConstIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    const TableType* Table = nullptr;
+    const BitmapType* Occupied = nullptr;
+    size_t First = 0, Second = 0;
+};
+
+// Hash map keeping up to InlineCapacity items inside the object and the rest in a HashMap.
+// While the items fit, they are stored unordered in an inline array and looked up by linear search with KeyEqual,
+// without hashing. Inserting one more distinct key moves all items into the HashMap, which keeps them until clear().
+// Default construction and clear() do not allocate memory, so short-lived maps of a few items never touch the heap.
+// Iterators point either to an inline item or wrap a HashMap iterator.
+template<class KeyType, class ValueType, size_t InlineCapacity = 8, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>,
+         class GrowthPolicy = PrimeGrowthPolicy, class Allocator = std::allocator<std::pair<const KeyType, ValueType>>>
+class SmallHashMap {
+    static_assert(InlineCapacity > 0, "SmallHashMap needs inline capacity");
+  public:
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef Allocator allocator_type;
+    typedef HashMap<KeyType, ValueType, Hash, KeyEqual, GrowthPolicy, Allocator> map_type;
+    typedef HashMapSlot<KeyType, ValueType> slot_type;
+    typedef SmallHashMapIterator<slot_type, typename map_type::iterator> iterator;
+    typedef SmallHashMapConstIterator<slot_type, typename map_type::const_iterator> const_iterator;
+    // Enables lookup overloads for key type K if Hash and KeyEqual are transparent.
+    template<class K>
+    using TransparentKey = typename std::enable_if<IsTransparentLookup<Hash, KeyEqual>::value && !std::is_convertible<const K&, iterator>::value, K>::type;
+    // Default constructor. Does not allocate memory.
+    SmallHashMap() {}
+    // Constructor for begin and end iterators.
+    template<class Iterator>
+    SmallHashMap(Iterator first, Iterator last) {
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list.
+    SmallHashMap(std::initializer_list<std::pair<KeyType, ValueType>> List) {
+        reserve(List.size());
+        for (auto& i : List) {
+            insert(i);
+        }
+    }
+    // Default constructor with allocator.
+    explicit SmallHashMap(const Allocator& Alloc): Large(Alloc) {}
+    // Default constructor with custom hash function, key equality and allocator.
+    SmallHashMap(const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : Large(HashFunction, Equal, Alloc) {}
+    // Copy constructor in O(size) time.
+    SmallHashMap(const SmallHashMap& Oth): Large(Oth.Large), Promoted(Oth.Promoted) {
+        for (; Count != Oth.Count; ++Count) {
+            ::new (static_cast<void*>(inline_slots() + Count)) slot_type(Oth.inline_slots()[Count]);
+        }
+    }
+    // Move constructor. Moves inline items one by one in O(InlineCapacity) time. Oth is left empty.
+    SmallHashMap(SmallHashMap&& Oth): Large(std::move(Oth.Large)), Promoted(Oth.Promoted) {
+        for (; Count != Oth.Count; ++Count) {
+            ::new (static_cast<void*>(inline_slots() + Count)) slot_type(std::move(Oth.inline_slots()[Count]));
+        }
+        Oth.clear();
+    }
+    // Destroys every item in O(size) time.
+    ~SmallHashMap() {
+        destroy_inline();
+    }
+    // Returns begin iterator in O(1) time.
+    iterator begin() {
+        return Promoted ? iterator(Large.begin()) : iterator(inline_slots());
+    }
+    // Returns end iterator in O(1) time.
+    iterator end() {
+        return Promoted ? iterator(Large.end()) : iterator(inline_slots() + Count);
+    }
+    // Returns constant begin iterator in O(1) time.
+    const_iterator begin() const {
+        return Promoted ? const_iterator(Large.begin()) : const_iterator(inline_slots());
+    }
+    // Returns constant end iterator in O(1) time.
+    const_iterator end() const {
+        return Promoted ? const_iterator(Large.end()) : const_iterator(inline_slots() + Count);
+    }
+    // Returns hash function in O(1) time.
+    Hash hash_function() const {
+        return Large.hash_function();
+    }
+    // Returns key equality function in O(1) time.
+    KeyEqual key_eq() const {
+        return Large.key_eq();
+    }
+    // Returns allocator in O(1) time.
+    Allocator get_allocator() const {
+        return Large.get_allocator();
+    }
+    // Inserts copy of item if its key is absent in O(InlineCapacity) time, or in O(1) amortized time once items moved to the HashMap.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(const value_type& Item) {
+        return emplace_key(Item.first, Item);
+    }
+    // Inserts item by moving it if its key is absent in O(InlineCapacity) time, or in O(1) amortized time once items moved to the HashMap.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(value_type&& Item) {
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Inserts item constructed from Item, for example from a pair with mutable key, if its key is absent.
+    // Works in O(InlineCapacity) time, or in O(1) amortized time once items moved to the HashMap. May invalidate iterators.
+    template<class P, class = typename std::enable_if<std::is_constructible<value_type, P&&>::value>::type>
+    std::pair<iterator, bool> insert(P&& Item) {
+        return emplace(std::forward<P>(Item));
+    }
+    // Constructs item from args if its key is absent in O(InlineCapacity) time, or in O(1) amortized time once items moved to the HashMap.
+    // Arguments which are a key and a value or one pair are constructed only on insertion, other arguments are first
+    // constructed into a temporary pair. Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return emplace_decomposed(std::forward<Args>(args)...);
+    }
+    // Constructs item from key and args if the key is absent, otherwise leaves args untouched.
+    // Works in O(InlineCapacity) time, or in O(1) amortized time once items moved to the HashMap.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const KeyType& Key, Args&&... args) {
+        size_t i = prepare_insert(Key);
+        if (Promoted) {
+            return wrap(Large.try_emplace(Key, std::forward<Args>(args)...));
+        }
+        return emplace_inline(i, std::piecewise_construct, std::forward_as_tuple(Key), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Constructs item from moved key and args if the key is absent, otherwise leaves key and args untouched.
+    // Works in O(InlineCapacity) time, or in O(1) amortized time once items moved to the HashMap.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(KeyType&& Key, Args&&... args) {
+        size_t i = prepare_insert(Key);
+        if (Promoted) {
+            return wrap(Large.try_emplace(std::move(Key), std::forward<Args>(args)...));
+        }
+        return emplace_inline(i, std::piecewise_construct, std::forward_as_tuple(std::move(Key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Assigns Obj to item by key or inserts a new item if the key is absent.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const KeyType& Key, M&& Obj) {
+        auto Result = try_emplace(Key, std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Assigns Obj to item by moved key or inserts a new item if the key is absent.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(KeyType&& Key, M&& Obj) {
+        auto Result = try_emplace(std::move(Key), std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Erases item by key and returns number of erased items. The last inline item takes place of the erased one.
+    // Works in O(InlineCapacity) time, or in O(1) amortized time once items moved to the HashMap. May invalidate iterators.
+    size_t erase(const KeyType& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by key of type K comparable with KeyType and returns number of erased items.
+    // Enabled only for transparent Hash and KeyEqual. May invalidate iterators.
+    template<class K, class = TransparentKey<K>>
+    size_t erase(const K& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by iterator in O(1) time and returns iterator of the next item.
+    // Erasing while iterating visits every remaining item once.
+    iterator erase(iterator Pos) {
+        if (Promoted) {
+            return iterator(Large.erase(Pos.GetPosition()));
+        }
+        size_t i = Pos.GetSlot() - inline_slots();
+        del_inline(i);
+        return iterator(inline_slots() + i);
+    }
+    // Returns iterator of item by key in O(InlineCapacity) time, or in O(1) expected time once items moved to the HashMap.
+    iterator find(const KeyType& Key) {
+        return Promoted ? iterator(Large.find(Key)) : iterator(inline_slots() + find_inline(Key));
+    }
+    // Returns constant iterator of item by key in O(InlineCapacity) time, or in O(1) expected time once items moved to the HashMap.
+    const_iterator find(const KeyType& Key) const {
+        return Promoted ? const_iterator(Large.find(Key)) : const_iterator(inline_slots() + find_inline(Key));
+    }
+    // Returns iterator of item by key of type K comparable with KeyType. Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    iterator find(const K& Key) {
+        return Promoted ? iterator(Large.find(Key)) : iterator(inline_slots() + find_inline(Key));
+    }
+    // Returns constant iterator of item by key of type K comparable with KeyType. Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const_iterator find(const K& Key) const {
+        return Promoted ? const_iterator(Large.find(Key)) : const_iterator(inline_slots() + find_inline(Key));
+    }
+    // Returns number of items with key in O(InlineCapacity) time, or in O(1) expected time once items moved to the HashMap.
+    size_t count(const KeyType& Key) const {
+        return Promoted ? Large.count(Key) : find_inline(Key) != Count;
+    }
+    // Returns number of items with key of type K comparable with KeyType. Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    size_t count(const K& Key) const {
+        return Promoted ? Large.count(Key) : find_inline(Key) != Count;
+    }
+    // Returns true if an item with key is stored in O(InlineCapacity) time, or in O(1) expected time once items moved to the HashMap.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns true if an item with key of type K comparable with KeyType is stored. Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    bool contains(const K& Key) const {
+        return count(Key) != 0;
+    }
+    // Destroys every item in O(size) time and returns to inline storage. Does not allocate memory.
+    void clear() {
+        destroy_inline();
+        Count = 0;
+        Large.clear();
+        Promoted = false;
+    }
+    // Assigns *this to Oth. Works in O(Oth.size + *this.size) time.
+    SmallHashMap& operator=(const SmallHashMap& Oth) {
+        if (this != &Oth) {
+            clear();
+            Large = Oth.Large;
+            Promoted = Oth.Promoted;
+            for (; Count != Oth.Count; ++Count) {
+                ::new (static_cast<void*>(inline_slots() + Count)) slot_type(Oth.inline_slots()[Count]);
+            }
+        }
+        return *this;
+    }
+    // Moves Oth to *this in O(*this.size + InlineCapacity) time. Oth is left empty.
+    SmallHashMap& operator=(SmallHashMap&& Oth) {
+        if (this != &Oth) {
+            clear();
+            Large = std::move(Oth.Large);
+            Promoted = Oth.Promoted;
+            for (; Count != Oth.Count; ++Count) {
+                ::new (static_cast<void*>(inline_slots() + Count)) slot_type(std::move(Oth.inline_slots()[Count]));
+            }
+            Oth.clear();
+        }
+        return *this;
+    }
+    // Returns item by key. If no items stored by this key, creates a new item. May invalidate iterators.
+    ValueType& operator[](const KeyType& Key) {
+        return try_emplace(Key).first->second;
+    }
+    // Returns item by key. If no items stored by this key, creates a new item from moved key. May invalidate iterators.
+    ValueType& operator[](KeyType&& Key) {
+        return try_emplace(std::move(Key)).first->second;
+    }
+    // Returns item by key. If no items stored by this key, throws out of range exception. If an exception is thrown, there are no changes in the container.
+    const ValueType& at(const KeyType& Key) const {
+        return get_value(Key);
+    }
+    // Returns item by key of type K comparable with KeyType. If no items stored by this key, throws out of range exception.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const ValueType& at(const K& Key) const {
+        return get_value(Key);
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Promoted ? Large.size() : Count;
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return size() == 0;
+    }
+    // Returns true if items are stored inline in O(1) time.
+    bool is_inline() const {
+        return !Promoted;
+    }
+    // Makes room for n items in O(size + n) time: moves items to the HashMap if they do not fit inline and reserves its buckets.
+    // May invalidate iterators.
+    void reserve(size_t n) {
+        if (n > InlineCapacity && !Promoted) {
+            promote();
+        }
+        if (Promoted) {
+            Large.reserve(n);
+        }
+    }
+
+  private:
+    // Returns pointer to the inline item array in O(1) time.
+    slot_type* inline_slots() {
+        return std::launder(reinterpret_cast<slot_type*>(Storage));
+    }
+    // Returns constant pointer to the inline item array in O(1) time.
+    const slot_type* inline_slots() const {
+        return std::launder(reinterpret_cast<const slot_type*>(Storage));
+    }
+    // Returns number of inline item by key or Count if there is no such item. Works in O(Count) time.
+    template<class K>
+    size_t find_inline(const K& Key) const {
+        KeyEqual Equal = Large.key_eq();
+        const slot_type* Slots = inline_slots();
+        size_t i = 0;
+        while (i != Count && !Equal(Slots[i].Value.first, Key)) {
+            ++i;
+        }
+        return i;
+    }
+    // Returns item by key or throws out of range exception if there is no such item.
+    template<class K>
+    const ValueType& get_value(const K& Key) const {
+        if (Promoted) {
+            return Large.at(Key);
+        }
+        size_t i = find_inline(Key);
+        if (i == Count) {
+            throw std::out_of_range("incorrect key");
+        }
+        return inline_slots()[i].Value.second;
+    }
+    // Erases item by key and returns number of erased items.
+    template<class K>
+    size_t erase_key(const K& Key) {
+        if (Promoted) {
+            return Large.erase(Key);
+        }
+        size_t i = find_inline(Key);
+        if (i == Count) {
+            return 0;
+        }
+        del_inline(i);
+        return 1;
+    }
+    // Returns number of inline item by key, or Count if the key is absent and fits inline, in O(Count) time.
+    // If the key is absent and inline storage is full, moves items to the HashMap first. Does nothing once they are there.
+    size_t prepare_insert(const KeyType& Key) {
+        if (Promoted) {
+            return 0;
+        }
+        size_t i = find_inline(Key);
+        if (i == InlineCapacity) {
+            promote();
+        }
+        return i;
+    }
+    // Returns iterator of inline item number i and false, or if i is Count, constructs a new inline item from args
+    // and returns its iterator and true. Works in O(1) time.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_inline(size_t i, Args&&... args) {
+        if (i != Count) {
+            return {iterator(inline_slots() + i), false};
+        }
+        ::new (static_cast<void*>(inline_slots() + Count)) slot_type(std::in_place, std::forward<Args>(args)...);
+        return {iterator(inline_slots() + Count++), true};
+    }
+    // Finds key and if it is absent, constructs item from args inline or in the HashMap.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_key(const KeyType& Key, Args&&... args) {
+        size_t i = prepare_insert(Key);
+        if (Promoted) {
+            return wrap(Large.emplace(std::forward<Args>(args)...));
+        }
+        return emplace_inline(i, std::forward<Args>(args)...);
+    }
+    // Emplaces item constructed from key and value, looking the key up before construction.
+    template<class K, class V>
+    std::pair<iterator, bool> emplace_decomposed(K&& k, V&& v) {
+        if constexpr (std::is_same<typename std::decay<K>::type, KeyType>::value) {
+            return emplace_key(k, std::forward<K>(k), std::forward<V>(v));
+        } else {
+            KeyType Key(std::forward<K>(k));
+            return emplace_key(Key, std::move(Key), std::forward<V>(v));
+        }
+    }
+    // Emplaces item constructed from members of pair Item.
+    template<class P, class = decltype(std::declval<P&>().first)>
+    std::pair<iterator, bool> emplace_decomposed(P&& Item) {
+        return emplace_decomposed(std::forward<P>(Item).first, std::forward<P>(Item).second);
+    }
+    // Emplaces item constructed from arbitrary arguments through a temporary pair.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_decomposed(Args&&... args) {
+        std::pair<KeyType, ValueType> Item(std::forward<Args>(args)...);
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Wraps result of a HashMap insertion.
+    static std::pair<iterator, bool> wrap(std::pair<typename map_type::iterator, bool> Result) {
+        return {iterator(Result.first), Result.second};
+    }
+    // Erases inline item number i in O(1) time by moving the last inline item in its place.
+    void del_inline(size_t i) {
+        slot_type* Slots = inline_slots();
+        if (i + 1 != Count) {
+            Slots[i] = std::move(Slots[Count - 1]);
+        }
+        Slots[--Count].~slot_type();
+    }
+    // Moves every inline item to the HashMap in O(InlineCapacity) time.
+    void promote() {
+        Large.reserve(InlineCapacity + 1);
+        slot_type* Slots = inline_slots();
+        for (size_t i = 0; i != Count; ++i) {
+            Large.insert(std::move(Slots[i].mutable_value()));
+        }
+        destroy_inline();
+        Count = 0;
+        Promoted = true;
+    }
+    // Destroys inline items in O(Count) time.
+    void destroy_inline() {
+        slot_type* Slots = inline_slots();
+        for (size_t i = 0; i != Count; ++i) {
+            Slots[i].~slot_type();
+        }
+    }
+    map_type Large;
+    size_t Count = 0;
+    bool Promoted = false;
+    alignas(slot_type) unsigned char Storage[InlineCapacity * sizeof(slot_type)];
+};
+
+// Small hash map iterator implemented by storing either a pointer to an inline item or a HashMap iterator.
+// Guarantees iteration in O(size) time while items are inline and as HashMap iterators do afterwards.
+template<class SlotType, class MapIterator>
+class SmallHashMapIterator {
+  public:
+    typedef typename SlotType::value_type ValueType;
+    // Default constructor.
+    SmallHashMapIterator() {}
+    // Constructor by inline item pointer.
+    explicit SmallHashMapIterator(SlotType* s) {
+        Slot = s;
+    }
+    // Constructor by HashMap iterator.
+    explicit SmallHashMapIterator(MapIterator p) {
+        Position = p;
+    }
+    // Returns true if iterator is equal to Oth in O(1) time.
+    bool operator==(const SmallHashMapIterator &Oth) const {
+        return Slot == Oth.Slot && (Slot != nullptr || Position == Oth.Position);
+    }
+    // Returns true if iterator is not equal to Oth in O(1) time.
+    bool operator!=(const SmallHashMapIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns pointer to inline item, or null if the iterator wraps a HashMap iterator, in O(1) time.
+    SlotType* GetSlot() const {
+        return Slot;
+    }
+    // Returns wrapped HashMap iterator in O(1) time.
+    MapIterator GetPosition() const {
+        return Position;
+    }
+    // Returns item object in O(1) time.
+    ValueType& operator*() {
+        return Slot != nullptr ? Slot->Value : *Position;
+    }
+    // Returns item reference in O(1) time.
+    ValueType* operator->() {
+        return Slot != nullptr ? &Slot->Value : Position.operator->();
+    }
+    // Moves iterator to next item and returns it in O(1) expected time.
+    SmallHashMapIterator& operator++() {
+        if (Slot != nullptr) {
+            ++Slot;
+        } else {
+            ++Position;
+        }
+        return *this;
+    }
+    // Moves iterator to next item and returns its previous state in O(1) expected time.
+    SmallHashMapIterator operator++(int) {
+        SmallHashMapIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    SlotType* Slot = nullptr;
+    MapIterator Position;
+};
+
+// Constant small hash map iterator implemented by storing either a pointer to an inline item or a HashMap constant iterator.
+// Guarantees iteration in O(size) time while items are inline and as HashMap iterators do afterwards.
+template<class SlotType, class MapIterator>
+class SmallHashMapConstIterator {
+  public:
+    typedef typename SlotType::value_type ValueType;
+    // Default constructor.
+    SmallHashMapConstIterator() {}
+    // Constructor by inline item pointer.
+    explicit SmallHashMapConstIterator(const SlotType* s) {
+        Slot = s;
+    }
+    // Constructor by HashMap constant iterator.
+    explicit SmallHashMapConstIterator(MapIterator p) {
+        Position = p;
+    }
+    // Returns true if constant iterator is equal to Oth in O(1) time.
+    bool operator==(const SmallHashMapConstIterator &Oth) const {
+        return Slot == Oth.Slot && (Slot != nullptr || Position == Oth.Position);
+    }
+    // Returns true if constant iterator is not equal to Oth in O(1) time.
+    bool operator!=(const SmallHashMapConstIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns constant item object in O(1) time.
+    const ValueType& operator*() const {
+        return Slot != nullptr ? Slot->Value : *Position.operator->();
+    }
+    // Returns constant item reference in O(1) time.
+    const ValueType* operator->() const {
+        return Slot != nullptr ? &Slot->Value : Position.operator->();
+    }
+    // Moves constant iterator to next item and returns it in O(1) expected time.
+    SmallHashMapConstIterator& operator++() {
+        if (Slot != nullptr) {
+            ++Slot;
+        } else {
+            ++Position;
+        }
+        return *this;
+    }
+    // Moves constant iterator to next item and returns its previous state in O(1) expected time.
+    SmallHashMapConstIterator operator++(int) {
+        SmallHashMapConstIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    const SlotType* Slot = nullptr;
+    MapIterator Position;
+};
+
+// Set of matching control bytes in a group. Every match is one bit, its number shifted right by Shift is the byte offset.
+template<size_t Shift>
+class FlatHashMapBitMask {
+  public:
+    // Constructor by raw mask.
+    explicit FlatHashMapBitMask(uint64_t m): Mask(m) {}
+    // Returns true if there is at least one match in O(1) time.
+    explicit operator bool() const {
+        return Mask != 0;
+    }
+    // Returns byte offset of the lowest match in O(1) time. Mask must be nonzero.
+    size_t lowest() const {
+        return count_trailing_zeros(Mask) >> Shift;
+    }
+    // Returns number of bytes matching in a row from the start of the group in O(1) time.
+    size_t leading_matches() const {
+        uint64_t Gaps = ~Mask & (Shift == 0 ? ~uint64_t(0) : 0x8080808080808080ULL);
+        return Gaps == 0 ? 64 >> Shift : count_trailing_zeros(Gaps) >> Shift;
+    }
+    // Drops the lowest match in O(1) time.
+    FlatHashMapBitMask& operator++() {
+        Mask &= Mask - 1;
+        return *this;
+    }
+  private:
+    uint64_t Mask;
+};
+
+// Control byte values of FlatHashMap. Full slots store 7 low bits of the item hash, so they are nonnegative.
+// Empty, deleted and sentinel values have the highest bit set and are ordered so that one signed comparison classifies them.
+struct FlatHashMapControl {
+    static constexpr int8_t Empty = -128;
+    static constexpr int8_t Deleted = -2;
+    static constexpr int8_t Sentinel = -1;
+};
+
+#if defined(__AVX2__) && !defined(HASH_MAP_NO_SIMD)
+// Group of 32 control bytes matched with AVX2 instructions.
+class FlatHashMapGroup {
+  public:
+    static constexpr size_t Width = 32;
+    typedef FlatHashMapBitMask<0> BitMask;
+    // Loads Width control bytes starting from c. The bytes do not have to be aligned.
+    explicit FlatHashMapGroup(const int8_t* c): Control(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(c))) {}
+    // Returns bytes equal to h in O(1) time.
+    BitMask match(int8_t h) const {
+        return BitMask(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(h), Control))));
+    }
+    // Returns empty bytes in O(1) time.
+    BitMask match_empty() const {
+        return match(FlatHashMapControl::Empty);
+    }
+    // Returns empty and deleted bytes in O(1) time.
+    BitMask match_empty_or_deleted() const {
+        return BitMask(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(FlatHashMapControl::Sentinel), Control))));
+    }
+  private:
+    __m256i Control;
+};
+#elif defined(__SSE2__) && !defined(HASH_MAP_NO_SIMD)
+// Group of 16 control bytes matched with SSE2 instructions.
+class FlatHashMapGroup {
+  public:
+    static constexpr size_t Width = 16;
+    typedef FlatHashMapBitMask<0> BitMask;
+    // Loads Width control bytes starting from c. The bytes do not have to be aligned.
+    explicit FlatHashMapGroup(const int8_t* c): Control(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c))) {}
+    // Returns bytes equal to h in O(1) time.
+    BitMask match(int8_t h) const {
+        return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), Control))));
+    }
+    // Returns empty bytes in O(1) time.
+    BitMask match_empty() const {
+        return match(FlatHashMapControl::Empty);
+    }
+    // Returns empty and deleted bytes in O(1) time.
+    BitMask match_empty_or_deleted() const {
+        return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(FlatHashMapControl::Sentinel), Control))));
+    }
+  private:
+    __m128i Control;
+};
+#else
+// Group of 8 control bytes matched with 64-bit integer arithmetic. Used when SIMD is not available.
+// Every byte reports the match in its highest bit, so offsets are bit numbers divided by 8.
+class FlatHashMapGroup {
+  public:
+    static constexpr size_t Width = 8;
+    typedef FlatHashMapBitMask<3> BitMask;
+    // Loads Width control bytes starting from c. The bytes do not have to be aligned.
+    explicit FlatHashMapGroup(const int8_t* c) {
+        std::memcpy(&Control, c, sizeof(Control));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        Control = __builtin_bswap64(Control);
+#endif
+    }
+    // Returns bytes equal to h in O(1) time. May report a full byte next to a real match, callers compare keys anyway.
+    BitMask match(int8_t h) const {
+        uint64_t x = Control ^ (Lsbs * static_cast<uint8_t>(h));
+        return BitMask((x - Lsbs) & ~x & Msbs);
+    }
+    // Returns empty bytes in O(1) time. Only empty bytes have the highest bit set and the second lowest bit clear.
+    BitMask match_empty() const {
+        return BitMask((Control & ~(Control << 6)) & Msbs);
+    }
+    // Returns empty and deleted bytes in O(1) time. Only they have the highest bit set and the lowest bit clear.
+    BitMask match_empty_or_deleted() const {
+        return BitMask((Control & ~(Control << 7)) & Msbs);
+    }
+  private:
+    static constexpr uint64_t Lsbs = 0x0101010101010101ULL;
+    static constexpr uint64_t Msbs = 0x8080808080808080ULL;
+    uint64_t Control;
+};
+#endif
+
+// Open addressing hash table storing all items in one contiguous array.
+// Every slot has a control byte telling whether it is empty, deleted or full. Full bytes keep 7 bits of the item hash,
+// so lookup compares a whole group of control bytes with one SIMD instruction (see FlatHashMapGroup) and calls
+// operator== only on slots whose bits match. Groups are probed quadratically, a group with an empty byte ends the probe.
+// Erased items leave deleted marks (tombstones) which are dropped on the next rehash.
+// Capacity is always a power of two minus one and at most 7/8 of slots are used, so every probe ends on an empty slot.
+// Control array keeps a sentinel after the last slot followed by copies of the first Width - 1 bytes,
+// so a group may be loaded from any slot without wrapping.
+// https://abseil.io/about/design/swisstables
+// Public interface is the same as in HashMap, so call sites can switch between them.
+// Allocator is rebound for slots and control bytes.
+// If StoreHash is true, every slot keeps the full mixed hash: resizing does not call the hash function and
+// lookups compare keys only on equal hashes, not just on equal 7 bits of the control byte.
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>,
+         class Allocator = std::allocator<std::pair<const KeyType, ValueType>>, bool StoreHash = false>
+class FlatHashMap {
+  public:
+    static constexpr size_t MinCapacity = FlatHashMapGroup::Width < 8 ? 7 : FlatHashMapGroup::Width - 1;
+    static constexpr float DefaultMaxLoadFactor = 0.875f;
+    // Number of keys whose lookups overlap in find_batch() and contains_batch().
+    static constexpr size_t BatchSize = 16;
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef HashMapSlot<KeyType, ValueType, StoreHash> slot_type;
+    typedef FlatHashMapIterator<slot_type> iterator;
+    typedef FlatHashMapConstIterator<slot_type> const_iterator;
+    typedef Allocator allocator_type;
+    // Enables lookup overloads for key type K if Hash and KeyEqual are transparent.
+    template<class K>
+    using TransparentKey = typename std::enable_if<IsTransparentLookup<Hash, KeyEqual>::value && !std::is_convertible<const K&, iterator>::value, K>::type;
+    // Default constructor. Does not allocate memory.
+    FlatHashMap() {
+        initialize();
+    }
+    // Constructor for begin and end iterators. Sizes table once if iterators are random access.
+    template<class Iterator>
+    FlatHashMap(Iterator first, Iterator last) {
+        initialize();
+        presize(first, last);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for begin and end iterators with expected number of items. Sizes table once for SizeHint items.
+    template<class Iterator>
+    FlatHashMap(Iterator first, Iterator last, size_t SizeHint) {
+        initialize();
+        presize(SizeHint);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list.
+    FlatHashMap(std::initializer_list<std::pair<KeyType, ValueType>> List) {
+        initialize();
+        presize(List.size());
+        for (auto& i : List) {
+            insert(i);
+        }
+    }
+    // Default constructor with allocator.
+    explicit FlatHashMap(const Allocator& Alloc): Alloc(Alloc), Control(ControlAllocator(Alloc)) {
+        initialize();
+    }
+    // Default constructor with custom hash function, key equality and allocator.
+    FlatHashMap(const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Alloc(Alloc), Control(ControlAllocator(Alloc)) {
+        initialize();
+    }
+    // Constructor for begin and end iterators with custom hash function, key equality and allocator.
+    template<class Iterator>
+    FlatHashMap(Iterator first, Iterator last, const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Alloc(Alloc), Control(ControlAllocator(Alloc)) {
+        initialize();
+        presize(first, last);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list with custom hash function, key equality and allocator.
+    FlatHashMap(std::initializer_list<std::pair<KeyType, ValueType>> List, const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Alloc(Alloc), Control(ControlAllocator(Alloc)) {
+        initialize();
+        presize(List.size());
+        for (auto& i : List) {
+            insert(i);
+        }
+    }
+    // Copy constructor. Copies every item into the slot of the same number in O(capacity) time.
+    FlatHashMap(const FlatHashMap& Oth)
+        : HashFunction(Oth.HashFunction), Equal(Oth.Equal), Alloc(AllocatorTraits::select_on_container_copy_construction(Oth.Alloc)), Control(ControlAllocator(Alloc)) {
+        initialize();
+        copy_from(Oth);
+    }
+    // Move constructor in O(1) time. Oth is left empty. Does not throw unless moving Hash or KeyEqual throws.
+    FlatHashMap(FlatHashMap&& Oth) noexcept(std::is_nothrow_move_constructible<Hash>::value && std::is_nothrow_move_constructible<KeyEqual>::value)
+        : HashFunction(std::move(Oth.HashFunction)), Equal(std::move(Oth.Equal)), Alloc(Oth.Alloc), Control(std::move(Oth.Control)), Slots(Oth.Slots),
+          Capacity(Oth.Capacity), Sz(Oth.Sz), Tombstones(Oth.Tombstones), MaxLoadFactor(Oth.MaxLoadFactor) {
+        Oth.initialize();
+    }
+    // Destroys every item and frees slots in O(capacity) time.
+    ~FlatHashMap() {
+        destroy();
+    }
+    // Returns begin iterator in O(capacity) time.
+    iterator begin() {
+        return get_iterator(0).skip();
+    }
+    // Returns end iterator in O(1) time.
+    iterator end() {
+        return get_iterator(Capacity);
+    }
+    // Returns constant begin iterator in O(capacity) time.
+    const_iterator begin() const {
+        return get_iterator(0).skip();
+    }
+    // Returns constant end iterator in O(1) time.
+    const_iterator end() const {
+        return get_iterator(Capacity);
+    }
+    // Returns hash function in O(1) time.
+    Hash hash_function() const {
+        return HashFunction;
+    }
+    // Returns key equality function in O(1) time.
+    KeyEqual key_eq() const {
+        return Equal;
+    }
+    // Returns allocator in O(1) time.
+    Allocator get_allocator() const {
+        return Allocator(Alloc);
+    }
+    // Inserts copy of item if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(const value_type& Item) {
+        return emplace_key(Item.first, Item);
+    }
+    // Inserts item by moving it if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(value_type&& Item) {
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Inserts item constructed from Item, for example from a pair with mutable key, if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class P, class = typename std::enable_if<std::is_constructible<value_type, P&&>::value>::type>
+    std::pair<iterator, bool> insert(P&& Item) {
+        return emplace(std::forward<P>(Item));
+    }
+    // Constructs item from args if its key is absent in O(1) amortized time. Arguments which are a key and a value
+    // or one pair are constructed only on insertion, other arguments are first constructed into a temporary pair.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return emplace_decomposed(std::forward<Args>(args)...);
+    }
+    // Constructs item from key and args if the key is absent in O(1) amortized time, otherwise leaves args untouched.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const KeyType& Key, Args&&... args) {
+        return emplace_key(Key, std::piecewise_construct, std::forward_as_tuple(Key), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Constructs item from moved key and args if the key is absent in O(1) amortized time, otherwise leaves key and args untouched.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(KeyType&& Key, Args&&... args) {
+        return emplace_key(Key, std::piecewise_construct, std::forward_as_tuple(std::move(Key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Assigns Obj to item by key or inserts a new item if the key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const KeyType& Key, M&& Obj) {
+        auto Result = try_emplace(Key, std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Assigns Obj to item by moved key or inserts a new item if the key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(KeyType&& Key, M&& Obj) {
+        auto Result = try_emplace(std::move(Key), std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Erases item by key in O(1) expected time and returns number of erased items.
+    // Leaves a deleted mark in the slot. Does not invalidate other iterators.
+    size_t erase(const KeyType& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by key of type K comparable with KeyType in O(1) expected time and returns number of erased items.
+    // Enabled only for transparent Hash and KeyEqual. Does not invalidate other iterators.
+    template<class K, class = TransparentKey<K>>
+    size_t erase(const K& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by iterator in O(1) time and returns iterator of the next item. Does not invalidate other iterators.
+    iterator erase(iterator Pos) {
+        del(Pos.GetControl() - Control.data());
+        return ++Pos;
+    }
+    // Erases items in range [First, Last) in O(slots in range) time and returns Last. Does not invalidate other iterators.
+    iterator erase(iterator First, iterator Last) {
+        while (First != Last) {
+            First = erase(First);
+        }
+        return Last;
+    }
+    // Returns iterator of item by key in O(probe length) time. If hash function is good, works in O(1) expected time.
+    iterator find(const KeyType& Key) {
+        return get_iterator(find_index(Key));
+    }
+    // Returns constant iterator of item by key in O(probe length) time. If hash function is good, works in O(1) expected time.
+    const_iterator find(const KeyType& Key) const {
+        return get_iterator(find_index(Key));
+    }
+    // Returns iterator of item by key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    iterator find(const K& Key) {
+        return get_iterator(find_index(Key));
+    }
+    // Returns constant iterator of item by key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const_iterator find(const K& Key) const {
+        return get_iterator(find_index(Key));
+    }
+    // Returns iterator of item by key with hash function value KeyHash computed by the caller in O(1) expected time.
+    iterator find(const KeyType& Key, size_t KeyHash) {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns constant iterator of item by key with hash function value KeyHash computed by the caller in O(1) expected time.
+    const_iterator find(const KeyType& Key, size_t KeyHash) const {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns iterator of item by key of type K with hash function value KeyHash computed by the caller in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    iterator find(const K& Key, size_t KeyHash) {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns constant iterator of item by key of type K with hash function value KeyHash computed by the caller in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const_iterator find(const K& Key, size_t KeyHash) const {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns number of items with key in O(1) expected time.
+    size_t count(const KeyType& Key) const {
+        return find_index(Key) != Capacity;
+    }
+    // Returns number of items with key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    size_t count(const K& Key) const {
+        return find_index(Key) != Capacity;
+    }
+    // Returns true if an item with key is stored in O(1) expected time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns true if an item with key of type K comparable with KeyType is stored in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    bool contains(const K& Key) const {
+        return count(Key) != 0;
+    }
+    // Writes iterators of items by keys of range [first, last) to out in key order and returns the end of output.
+    // Keys are looked up in groups of BatchSize: hashes of a group are computed and its first probed control bytes
+    // and slots prefetched first, so cache misses of different keys overlap. Works in O(1) expected time per key.
+    // KeyIterator must be forward.
+    template<class KeyIterator, class OutIterator>
+    OutIterator find_batch(KeyIterator first, KeyIterator last, OutIterator out) {
+        lookup_batch(first, last, [this, &out](size_t i) { *out++ = get_iterator(i); });
+        return out;
+    }
+    // Writes constant iterators of items by keys of range [first, last) to out in key order and returns the end of output.
+    // Works in O(1) expected time per key, see find_batch().
+    template<class KeyIterator, class OutIterator>
+    OutIterator find_batch(KeyIterator first, KeyIterator last, OutIterator out) const {
+        lookup_batch(first, last, [this, &out](size_t i) { *out++ = get_iterator(i); });
+        return out;
+    }
+    // Writes to out whether items by keys of range [first, last) are stored, in key order, and returns the end of output.
+    // Works in O(1) expected time per key, see find_batch().
+    template<class KeyIterator, class OutIterator>
+    OutIterator contains_batch(KeyIterator first, KeyIterator last, OutIterator out) const {
+        lookup_batch(first, last, [this, &out](size_t i) { *out++ = i != Capacity; });
+        return out;
+    }
+    // Clears table and frees slots in O(capacity) time.
+    void clear() {
+        destroy();
+        initialize();
+    }
+    // Assigns *this to Oth. Copies items into a new table with the allocator of *this and then swaps tables.
+    // Works in O(Oth.capacity + *this.capacity) time. If an exception is thrown, there are no changes in the container.
+    FlatHashMap& operator=(const FlatHashMap& Oth) {
+        if (this != &Oth) {
+            FlatHashMap Copy(Oth.HashFunction, Oth.Equal, Alloc);
+            Copy.copy_from(Oth);
+            swap(Copy);
+        }
+        return *this;
+    }
+    // Moves Oth to *this in O(*this.capacity) time. Oth is left empty.
+    FlatHashMap& operator=(FlatHashMap&& Oth) noexcept {
+        if (this != &Oth) {
+            clear();
+            swap(Oth);
+        }
+        return *this;
+    }
+    // Returns item by key in O(1) amortized expected time. If no items stored by this key, creates a new item.
+    ValueType& operator[](const KeyType& Key) {
+        return try_emplace(Key).first->second;
+    }
+    // Returns item by key in O(1) amortized expected time. If no items stored by this key, creates a new item from moved key.
+    ValueType& operator[](KeyType&& Key) {
+        return try_emplace(std::move(Key)).first->second;
+    }
+    // Returns item by key in O(1) expected time. If no items stored by this key, throws out of range exception. If an exception is thrown, there are no changes in the container.
+    const ValueType& at(const KeyType& Key) const {
+        return get_value(Key);
+    }
+    // Returns item by key of type K comparable with KeyType in O(1) expected time. If no items stored by this key, throws out of range exception.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const ValueType& at(const K& Key) const {
+        return get_value(Key);
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Sz;
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return Sz == 0;
+    }
+    // Swaps contents with Oth in O(1) time.
+    void swap(FlatHashMap& Oth) noexcept {
+        std::swap(HashFunction, Oth.HashFunction);
+        std::swap(Equal, Oth.Equal);
+        std::swap(Alloc, Oth.Alloc);
+        std::swap(Control, Oth.Control);
+        std::swap(Slots, Oth.Slots);
+        std::swap(Capacity, Oth.Capacity);
+        std::swap(Sz, Oth.Sz);
+        std::swap(Tombstones, Oth.Tombstones);
+        std::swap(MaxLoadFactor, Oth.MaxLoadFactor);
+    }
+    // Returns number of slots in O(1) time.
+    size_t bucket_count() const {
+        return Capacity;
+    }
+    // Returns part of slots storing items in O(1) time.
+    float load_factor() const {
+        return Capacity == 0 ? 0 : static_cast<float>(Sz) / Capacity;
+    }
+    // Returns maximum part of used (full or deleted) slots in O(1) time.
+    float max_load_factor() const {
+        return MaxLoadFactor;
+    }
+    // Sets maximum part of used slots. Rehashes table in O(size + capacity) time if it becomes dense.
+    // If the factor is not in (0, 1) interval, throws invalid argument exception. At least one slot always stays empty.
+    void max_load_factor(float f) {
+        if (!(f > 0 && f < 1)) {
+            throw std::invalid_argument("incorrect load factor");
+        }
+        MaxLoadFactor = f;
+        if (Sz + Tombstones > max_size_for(Capacity)) {
+            resize(capacity_for(Sz));
+        }
+    }
+    // Sets capacity to at least n slots and at least enough for size() items, dropping all deleted marks.
+    // Works in O(size + capacity) time. Rehashing an empty table to zero slots frees them. Invalidates iterators.
+    void rehash(size_t n) {
+        if (n == 0 && Sz == 0) {
+            clear();
+            return;
+        }
+        size_t c = capacity_for(Sz);
+        while (c < n) {
+            c = c * 2 + 1;
+        }
+        if (c != Capacity || Tombstones != 0) {
+            resize(c);
+        }
+    }
+    // Sets capacity enough for n items in O(size + capacity) time, so that inserting them does not resize table.
+    // Invalidates iterators.
+    void reserve(size_t n) {
+        if (max_size_for(Capacity) < n) {
+            resize(capacity_for(n));
+        }
+    }
+
+  private:
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type> SlotAllocator;
+    typedef std::allocator_traits<SlotAllocator> AllocatorTraits;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<int8_t> ControlAllocator;
+    // Control array of every table of zero capacity, like the empty group of Abseil: only the sentinel, which iterators
+    // stop at. Lookups and insertions into such tables read no control bytes.
+    static constexpr int8_t EmptyControl = FlatHashMapControl::Sentinel;
+    // Makes table of zero capacity without allocating. Control array stays empty; iterators read EmptyControl instead.
+    void initialize() {
+        Control.clear();
+        Slots = nullptr;
+        Capacity = 0;
+        Sz = 0;
+        Tombstones = 0;
+    }
+    // Mixes hash function of a key in O(1) time, so that identity hashes of close keys do not form long probe runs.
+    template<class K>
+    size_t get_hash(const K& Key) const {
+        return MurmurHashMixer()(HashFunction(Key));
+    }
+    // Returns maximum number of used (full or deleted) slots for capacity n. At least one slot always stays empty.
+    size_t max_size_for(size_t n) const {
+        return n == 0 ? 0 : std::min(static_cast<size_t>(n * MaxLoadFactor), n - 1);
+    }
+    // Returns the smallest capacity fitting n items in O(log n) time.
+    size_t capacity_for(size_t n) const {
+        size_t c = MinCapacity;
+        while (max_size_for(c) < n) {
+            c = c * 2 + 1;
+        }
+        return c;
+    }
+    // Grows table to fit n items in O(size + n) time.
+    void presize(size_t n) {
+        reserve(n);
+    }
+    // Grows table to fit items of [first, last) range if its length is known without iterating, otherwise does nothing.
+    template<class Iterator>
+    void presize(Iterator first, Iterator last) {
+        if constexpr (std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>::value) {
+            presize(static_cast<size_t>(std::distance(first, last)));
+        }
+    }
+    // Makes room for one more item in O(size + capacity) time. Grows table if it is full of items, otherwise drops deleted marks.
+    void grow() {
+        resize(Sz + 1 > max_size_for(Capacity) ? capacity_for(Sz + 1) : Capacity);
+    }
+    // Returns true if one more item can not be added without breaking the load limit.
+    bool is_dense() const {
+        return Sz + Tombstones + 1 > max_size_for(Capacity);
+    }
+    // Returns control array in O(1) time: the static EmptyControl while capacity is zero.
+    const int8_t* control() const {
+        return Control.empty() ? &EmptyControl : Control.data();
+    }
+    // Returns iterator for slot of number i in O(1) time.
+    iterator get_iterator(size_t i) {
+        return iterator(control() + i, Slots + i);
+    }
+    // Returns constant iterator for slot of number i in O(1) time.
+    const_iterator get_iterator(size_t i) const {
+        return const_iterator(control() + i, Slots + i);
+    }
+    // Returns mixed hash of item in Slot in O(1) time: the stored one or, without stored hashes, computed from its key.
+    size_t hash_of(const slot_type& Slot) const {
+        if constexpr (slot_type::Stored) {
+            return Slot.hash();
+        } else {
+            return get_hash(Slot.Value.first);
+        }
+    }
+    // Returns 7 bits of hash h stored in control byte of full slot.
+    static int8_t get_short_hash(size_t h) {
+        return static_cast<int8_t>(h & 0x7F);
+    }
+    // Returns slot number of item by key or capacity if there is no such item. Works in O(probe length) time.
+    template<class K>
+    size_t find_index(const K& Key) const {
+        if (Sz == 0) {
+            return Capacity;
+        }
+        return find_index(Key, get_hash(Key));
+    }
+    // Returns slot number of item by key with hash h or capacity if there is no such item. Works in O(probe length) time.
+    template<class K>
+    size_t find_index(const K& Key, size_t h) const {
+        if (Sz == 0) {
+            return Capacity;
+        }
+        int8_t ShortHash = get_short_hash(h);
+        for (size_t Offset = (h >> 7) & Capacity, Step = 0;; ) {
+            FlatHashMapGroup Group(Control.data() + Offset);
+            for (auto Match = Group.match(ShortHash); Match; ++Match) {
+                size_t i = (Offset + Match.lowest()) & Capacity;
+                if (Slots[i].hash_matches(h) && Equal(Slots[i].Value.first, Key)) {
+                    return i;
+                }
+            }
+            if (Group.match_empty()) {
+                return Capacity;
+            }
+            Step += FlatHashMapGroup::Width;
+            Offset = (Offset + Step) & Capacity;
+        }
+    }
+    // Returns number of the first empty or deleted slot in probe sequence of hash h. Table must have a free slot.
+    size_t find_free(size_t h) const {
+        for (size_t Offset = (h >> 7) & Capacity, Step = 0;; ) {
+            auto Match = FlatHashMapGroup(Control.data() + Offset).match_empty_or_deleted();
+            if (Match) {
+                return (Offset + Match.lowest()) & Capacity;
+            }
+            Step += FlatHashMapGroup::Width;
+            Offset = (Offset + Step) & Capacity;
+        }
+    }
+    // Returns item by key or throws out of range exception if there is no such item. Works in O(probe length) time.
+    template<class K>
+    const ValueType& get_value(const K& Key) const {
+        size_t i = find_index(Key);
+        if (i == Capacity) {
+            throw std::out_of_range("incorrect key");
+        }
+        return Slots[i].Value.second;
+    }
+    // Erases item by key and returns number of erased items. Works in O(probe length) time.
+    template<class K>
+    size_t erase_key(const K& Key) {
+        size_t i = find_index(Key);
+        if (i == Capacity) {
+            return 0;
+        }
+        del(i);
+        return 1;
+    }
+    // Looks up keys of range [first, last) in groups of BatchSize and calls f with slot number of every item in key order,
+    // or with capacity for absent keys. First probed control bytes and slots of a group are prefetched while hashing,
+    // then the group is resolved. Works in O(probe length) expected time per key.
+    template<class KeyIterator, class F>
+    void lookup_batch(KeyIterator first, KeyIterator last, F&& f) const {
+        size_t Hashes[BatchSize];
+        while (first != last) {
+            KeyIterator Group = first;
+            size_t n = 0;
+            for (; n != BatchSize && first != last; ++n, ++first) {
+                Hashes[n] = get_hash(*first);
+                size_t Offset = (Hashes[n] >> 7) & Capacity;
+                prefetch(Control.data() + Offset);
+                prefetch(Slots + Offset);
+            }
+            for (size_t k = 0; k != n; ++k, ++Group) {
+                f(find_index(*Group, Hashes[k]));
+            }
+        }
+    }
+    // Sets control byte of slot number i and its copy after the sentinel in O(1) time.
+    void set_control(size_t i, int8_t c) {
+        Control[i] = c;
+        if (i < FlatHashMapGroup::Width - 1) {
+            Control[Capacity + 1 + i] = c;
+        }
+    }
+    // Returns slot number of item by key and true, or number of a free slot where an item with this key should be
+    // constructed and false. One probe finds both: the free slot is the first empty or deleted one on the key probe sequence.
+    // Works in O(probe length) expected time, hash function is called once and h is set to its mixed value.
+    // If the free slot is empty and using it would break the load limit, the table grows beforehand, so the slot stays valid.
+    std::pair<size_t, bool> find_or_prepare_insert(const KeyType& Key, size_t& h) {
+        h = get_hash(Key);
+        size_t Free = Capacity;
+        if (Capacity != 0) {
+            int8_t ShortHash = get_short_hash(h);
+            for (size_t Offset = (h >> 7) & Capacity, Step = 0;; ) {
+                FlatHashMapGroup Group(Control.data() + Offset);
+                for (auto Match = Group.match(ShortHash); Match; ++Match) {
+                    size_t i = (Offset + Match.lowest()) & Capacity;
+                    if (Slots[i].hash_matches(h) && Equal(Slots[i].Value.first, Key)) {
+                        return {i, true};
+                    }
+                }
+                if (Free == Capacity) {
+                    auto Match = Group.match_empty_or_deleted();
+                    if (Match) {
+                        Free = (Offset + Match.lowest()) & Capacity;
+                    }
+                }
+                if (Group.match_empty()) {
+                    break;
+                }
+                Step += FlatHashMapGroup::Width;
+                Offset = (Offset + Step) & Capacity;
+            }
+        }
+        if (Free == Capacity || (Control[Free] == FlatHashMapControl::Empty && is_dense())) {
+            grow();
+            Free = find_free(h);
+        }
+        return {Free, false};
+    }
+    // Finds key and if it is absent, constructs item from args in a free slot in O(1) amortized expected time.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_key(const KeyType& Key, Args&&... args) {
+        size_t h;
+        auto Place = find_or_prepare_insert(Key, h);
+        if (!Place.second) {
+            construct(Place.first, h, std::forward<Args>(args)...);
+        }
+        return {get_iterator(Place.first), !Place.second};
+    }
+    // Emplaces item constructed from key and value, looking the key up before construction.
+    template<class K, class V>
+    std::pair<iterator, bool> emplace_decomposed(K&& k, V&& v) {
+        if constexpr (std::is_same<typename std::decay<K>::type, KeyType>::value) {
+            return emplace_key(k, std::forward<K>(k), std::forward<V>(v));
+        } else {
+            KeyType Key(std::forward<K>(k));
+            return emplace_key(Key, std::move(Key), std::forward<V>(v));
+        }
+    }
+    // Emplaces item constructed from members of pair Item.
+    template<class P, class = decltype(std::declval<P&>().first)>
+    std::pair<iterator, bool> emplace_decomposed(P&& Item) {
+        return emplace_decomposed(std::forward<P>(Item).first, std::forward<P>(Item).second);
+    }
+    // Emplaces item constructed from arbitrary arguments through a temporary pair.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_decomposed(Args&&... args) {
+        std::pair<KeyType, ValueType> Item(std::forward<Args>(args)...);
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Constructs item from args in free slot of number i for hash h in O(1) time.
+    template<class... Args>
+    void construct(size_t i, size_t h, Args&&... args) {
+        AllocatorTraits::construct(Alloc, Slots + i, std::in_place, std::forward<Args>(args)...);
+        Slots[i].set_hash(h);
+        if (Control[i] == FlatHashMapControl::Deleted) {
+            --Tombstones;
+        }
+        set_control(i, get_short_hash(h));
+        ++Sz;
+    }
+    // Moves item From into free slot of number i for hash h and destroys From in O(1) time.
+    // Trivially copyable items are relocated by copying their bytes.
+    void relocate(size_t i, size_t h, slot_type& From) {
+        if constexpr (slot_type::TriviallyRelocatable) {
+            std::memcpy(static_cast<void*>(Slots + i), static_cast<const void*>(&From), sizeof(slot_type));
+        } else {
+            AllocatorTraits::construct(Alloc, Slots + i, std::move(From));
+            AllocatorTraits::destroy(Alloc, &From);
+        }
+        set_control(i, get_short_hash(h));
+        ++Sz;
+    }
+    // Destroys item in slot of number i and marks the slot deleted in O(1) time.
+    void del(size_t i) {
+        AllocatorTraits::destroy(Alloc, Slots + i);
+        set_control(i, FlatHashMapControl::Deleted);
+        --Sz;
+        ++Tombstones;
+    }
+    // Changes capacity to n in O(size + n) time, dropping all deleted marks. Items are moved, not copied.
+    // n must be a power of two minus one.
+    void resize(size_t n) {
+        std::vector<int8_t, ControlAllocator> OldControl(n + FlatHashMapGroup::Width, FlatHashMapControl::Empty, Control.get_allocator());
+        OldControl[n] = FlatHashMapControl::Sentinel;
+        slot_type* OldSlots = AllocatorTraits::allocate(Alloc, n);
+        size_t OldCapacity = Capacity;
+        std::swap(OldControl, Control);
+        std::swap(OldSlots, Slots);
+        Capacity = n;
+        Sz = 0;
+        Tombstones = 0;
+        size_t i = 0;
+        try {
+            for (; i != OldCapacity; ++i) {
+                if (OldControl[i] >= 0) {
+                    size_t h = hash_of(OldSlots[i]);
+                    relocate(find_free(h), h, OldSlots[i]);
+                }
+            }
+        } catch (...) {
+            // Items moved so far stay in the new table; the rest, including the one which failed to move, are lost.
+            for (; i != OldCapacity; ++i) {
+                if (OldControl[i] >= 0) {
+                    AllocatorTraits::destroy(Alloc, OldSlots + i);
+                }
+            }
+            if (OldSlots != nullptr) {
+                AllocatorTraits::deallocate(Alloc, OldSlots, OldCapacity);
+            }
+            throw;
+        }
+        if (OldSlots != nullptr) {
+            AllocatorTraits::deallocate(Alloc, OldSlots, OldCapacity);
+        }
+    }
+    // Copies items of Oth into the same slot numbers of an empty table in O(Oth.capacity) time.
+    // A slot is marked full only after its item is constructed, so if a copy throws, the items copied so far
+    // are destroyed and the table is left empty.
+    void copy_from(const FlatHashMap& Oth) {
+        MaxLoadFactor = Oth.MaxLoadFactor;
+        if (Oth.Capacity == 0) {
+            return;
+        }
+        Control.assign(Oth.Control.size(), FlatHashMapControl::Empty);
+        Control[Oth.Capacity] = FlatHashMapControl::Sentinel;
+        Slots = AllocatorTraits::allocate(Alloc, Oth.Capacity);
+        Capacity = Oth.Capacity;
+        try {
+            for (size_t i = 0; i != Capacity; ++i) {
+                if (Oth.Control[i] >= 0) {
+                    AllocatorTraits::construct(Alloc, Slots + i, Oth.Slots[i]);
+                    ++Sz;
+                }
+                if (Oth.Control[i] != FlatHashMapControl::Empty) {
+                    set_control(i, Oth.Control[i]);
+                }
+            }
+        } catch (...) {
+            destroy();
+            initialize();
+            throw;
+        }
+        Tombstones = Oth.Tombstones;
+    }
+    // Destroys every item and frees slots in O(capacity) time.
+    void destroy() {
+        for (size_t i = 0; i != Capacity; ++i) {
+            if (Control[i] >= 0) {
+                AllocatorTraits::destroy(Alloc, Slots + i);
+            }
+        }
+        if (Slots != nullptr) {
+            AllocatorTraits::deallocate(Alloc, Slots, Capacity);
+        }
+    }
+    Hash HashFunction;
+    KeyEqual Equal;
+    SlotAllocator Alloc;
+    std::vector<int8_t, ControlAllocator> Control;
+    slot_type* Slots = nullptr;
+    size_t Capacity = 0;
+    size_t Sz = 0;
+    size_t Tombstones = 0;
+    float MaxLoadFactor = DefaultMaxLoadFactor;
+};
+
+// Open addressing hash table iterator implemented by storing pointers to control byte and slot.
+// Skips empty and deleted slots, guarantees iteration in O(capacity) time.
+template<class SlotType>
+class FlatHashMapIterator {
+  public:
+    typedef typename SlotType::value_type ValueType;
+    // Default constructor.
+    FlatHashMapIterator() {}
+    // Constructor by control byte and slot pointers.
+    FlatHashMapIterator(const int8_t* c, SlotType* s) {
+        Control = c;
+        Slot = s;
+    }
+    // Returns true if iterator is equal to Oth in O(1) time.
+    bool operator==(const FlatHashMapIterator &Oth) const {
+        return Control == Oth.Control;
+    }
+    // Returns true if iterator is not equal to Oth in O(1) time.
+    bool operator!=(const FlatHashMapIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns pointer to control byte of the slot in O(1) time.
+    const int8_t* GetControl() const {
+        return Control;
+    }
+    // Returns item object in O(1) time.
+    ValueType& operator*() const {
+        return Slot->Value;
+    }
+    // Returns item reference in O(1) time.
+    ValueType* operator->() const {
+        return &Slot->Value;
+    }
+    // Moves iterator to the nearest full slot or the end if it does not point to one.
+    // Skips a whole group of empty and deleted slots per step, so works in O(skipped slots / group width + 1) time.
+    FlatHashMapIterator& skip() {
+        while (*Control < FlatHashMapControl::Sentinel) {
+            size_t n = FlatHashMapGroup(Control).match_empty_or_deleted().leading_matches();
+            Control += n;
+            Slot += n;
+        }
+        return *this;
+    }
+    // Moves iterator to next item and returns it in O(1) expected time.
+    FlatHashMapIterator& operator++() {
+        ++Control;
+        ++Slot;
+        return skip();
+    }
+    // Moves iterator to next item and returns its previous state in O(1) expected time.
+    FlatHashMapIterator operator++(int) {
+        FlatHashMapIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    const int8_t* Control = nullptr;
+    SlotType* Slot = nullptr;
+};
+
+// Constant open addressing hash table iterator implemented by storing pointers to control byte and slot.
+// Skips empty and deleted slots, guarantees iteration in O(capacity) time.
+template<class SlotType>
+class FlatHashMapConstIterator {
+  public:
+    typedef typename SlotType::value_type ValueType;
+    // Default constructor.
+    FlatHashMapConstIterator() {}
+    // Constructor by control byte and slot pointers.
+    FlatHashMapConstIterator(const int8_t* c, const SlotType* s) {
+        Control = c;
+        Slot = s;
+    }
+    // Returns true if constant iterator is equal to Oth in O(1) time.
+    bool operator==(const FlatHashMapConstIterator &Oth) const {
+        return Control == Oth.Control;
+    }
+    // Returns true if constant iterator is not equal to Oth in O(1) time.
+    bool operator!=(const FlatHashMapConstIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns constant item object in O(1) time.
+    const ValueType& operator*() const {
+        return Slot->Value;
+    }
+    // Returns constant item reference in O(1) time.
+    const ValueType* operator->() const {
+        return &Slot->Value;
+    }
+    // Moves constant iterator to the nearest full slot or the end if it does not point to one.
+    // Skips a whole group of empty and deleted slots per step, so works in O(skipped slots / group width + 1) time.
+    FlatHashMapConstIterator& skip() {
+        while (*Control < FlatHashMapControl::Sentinel) {
+            size_t n = FlatHashMapGroup(Control).match_empty_or_deleted().leading_matches();
+            Control += n;
+            Slot += n;
+        }
+        return *this;
+    }
+    // Moves constant iterator to next item and returns it in O(1) expected time.
+    FlatHashMapConstIterator& operator++() {
+        ++Control;
+        ++Slot;
+        return skip();
+    }
+    // Moves constant iterator to next item and returns its previous state in O(1) expected time.
+    FlatHashMapConstIterator operator++(int) {
+        FlatHashMapConstIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    const int8_t* Control = nullptr;
+    const SlotType* Slot = nullptr;
+};
+
+// Item of OrderedHashMap array: a slot storing an item, or the hole left by an erased item until holes are compacted.
+template<class SlotType>
+struct OrderedHashMapEntry {
+    typedef typename SlotType::value_type value_type;
+    // Constructs item from args.
+    template<class... Args>
+    explicit OrderedHashMapEntry(std::in_place_t, Args&&... args) {
+        new (&Slot) SlotType(std::in_place, std::forward<Args>(args)...);
+        Live = true;
+    }
+    // Copy constructor. A hole is copied as a hole.
+    OrderedHashMapEntry(const OrderedHashMapEntry& Oth) {
+        if (Oth.Live) {
+            new (&Slot) SlotType(Oth.Slot);
+        }
+        Live = Oth.Live;
+    }
+    // Move constructor. A hole is moved as a hole.
+    OrderedHashMapEntry(OrderedHashMapEntry&& Oth) noexcept(std::is_nothrow_move_constructible<SlotType>::value) {
+        if (Oth.Live) {
+            new (&Slot) SlotType(std::move(Oth.Slot));
+        }
+        Live = Oth.Live;
+    }
+    // Copy assignment.
+    OrderedHashMapEntry& operator=(const OrderedHashMapEntry& Oth) {
+        if (this != &Oth) {
+            erase();
+            if (Oth.Live) {
+                new (&Slot) SlotType(Oth.Slot);
+                Live = true;
+            }
+        }
+        return *this;
+    }
+    // Move assignment.
+    OrderedHashMapEntry& operator=(OrderedHashMapEntry&& Oth) noexcept(std::is_nothrow_move_constructible<SlotType>::value) {
+        if (this != &Oth) {
+            erase();
+            if (Oth.Live) {
+                new (&Slot) SlotType(std::move(Oth.Slot));
+                Live = true;
+            }
+        }
+        return *this;
+    }
+    // Destroys item if it is stored.
+    ~OrderedHashMapEntry() {
+        erase();
+    }
+    // Destroys item, leaving a hole, in O(1) time.
+    void erase() {
+        if (Live) {
+            Slot.~SlotType();
+            Live = false;
+        }
+    }
+    union {
+        SlotType Slot;
+    };
+    bool Live;
+};
+
+// Hash table keeping items in one array in insertion order, like Python dict.
+// The table itself stores only 32-bit numbers of items in the array, probed linearly from the mixed item hash,
+// so iteration is a sweep over contiguous memory and an empty table slot costs 4 bytes.
+// Every item keeps its mixed hash: resizing the table does not call the hash function and probes compare keys only on equal hashes.
+// Erasing leaves a hole in the array, which iterators skip. Once holes outnumber items, or when the table grows,
+// later items move back over the holes, keeping insertion order, so erasing works in O(1) amortized expected time.
+// Table capacity is a power of two and at least one slot always stays empty.
+// At most 2^32 - 2 items and holes are stored. Lookup and insertion interface is the same as in HashMap.
+// Allocator is rebound for items and item numbers.
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>,
+         class Allocator = std::allocator<std::pair<const KeyType, ValueType>>>
+class OrderedHashMap {
+  public:
+    static constexpr size_t MinCapacity = 8;
+    static constexpr float DefaultMaxLoadFactor = 0.75f;
+    // Item number of empty table slots.
+    static constexpr uint32_t EmptyIndex = ~uint32_t(0);
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef HashMapSlot<KeyType, ValueType, true> slot_type;
+    typedef OrderedHashMapEntry<slot_type> entry_type;
+    typedef OrderedHashMapIterator<entry_type> iterator;
+    typedef OrderedHashMapConstIterator<entry_type> const_iterator;
+    typedef Allocator allocator_type;
+    // Enables lookup overloads for key type K if Hash and KeyEqual are transparent.
+    template<class K>
+    using TransparentKey = typename std::enable_if<IsTransparentLookup<Hash, KeyEqual>::value && !std::is_convertible<const K&, iterator>::value, K>::type;
+    // Default constructor. Does not allocate memory.
+    OrderedHashMap() {}
+    // Constructor for begin and end iterators. Sizes table once if iterators are random access.
+    template<class Iterator>
+    OrderedHashMap(Iterator first, Iterator last) {
+        presize(first, last);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for begin and end iterators with expected number of items. Sizes table once for SizeHint items.
+    template<class Iterator>
+    OrderedHashMap(Iterator first, Iterator last, size_t SizeHint) {
+        reserve(SizeHint);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list.
+    OrderedHashMap(std::initializer_list<std::pair<KeyType, ValueType>> List) {
+        reserve(List.size());
+        for (auto& i : List) {
+            insert(i);
+        }
+    }
+    // Default constructor with allocator.
+    explicit OrderedHashMap(const Allocator& Alloc): Entries(EntryAllocator(Alloc)), Index(IndexAllocator(Alloc)) {}
+    // Default constructor with custom hash function, key equality and allocator.
+    OrderedHashMap(const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Entries(EntryAllocator(Alloc)), Index(IndexAllocator(Alloc)) {}
+    // Constructor for begin and end iterators with custom hash function, key equality and allocator.
+    template<class Iterator>
+    OrderedHashMap(Iterator first, Iterator last, const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Entries(EntryAllocator(Alloc)), Index(IndexAllocator(Alloc)) {
+        presize(first, last);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list with custom hash function, key equality and allocator.
+    OrderedHashMap(std::initializer_list<std::pair<KeyType, ValueType>> List, const Hash& HashFunction, const KeyEqual& Equal = KeyEqual(), const Allocator& Alloc = Allocator())
+        : HashFunction(HashFunction), Equal(Equal), Entries(EntryAllocator(Alloc)), Index(IndexAllocator(Alloc)) {
+        reserve(List.size());
+        for (auto& i : List) {
+            insert(i);
+        }
+    }
+    // Copy constructor.
+    OrderedHashMap(const OrderedHashMap& Oth) = default;
+    // Move constructor in O(1) time. Oth is left empty. Does not throw unless moving Hash or KeyEqual throws.
+    OrderedHashMap(OrderedHashMap&& Oth) noexcept(std::is_nothrow_move_constructible<Hash>::value && std::is_nothrow_move_constructible<KeyEqual>::value)
+        : HashFunction(std::move(Oth.HashFunction)), Equal(std::move(Oth.Equal)), Entries(std::move(Oth.Entries)), Index(std::move(Oth.Index)),
+          MaxLoadFactor(Oth.MaxLoadFactor), Holes(Oth.Holes) {
+        Oth.clear();
+    }
+    // Assigns *this to Oth. Works in O(Oth.size + Oth.capacity + *this.size) time.
+    OrderedHashMap& operator=(const OrderedHashMap& Oth) = default;
+    // Moves Oth to *this in O(*this.size) time. Oth is left empty.
+    OrderedHashMap& operator=(OrderedHashMap&& Oth) noexcept {
+        if (this != &Oth) {
+            HashFunction = std::move(Oth.HashFunction);
+            Equal = std::move(Oth.Equal);
+            Entries = std::move(Oth.Entries);
+            Index = std::move(Oth.Index);
+            MaxLoadFactor = Oth.MaxLoadFactor;
+            Holes = Oth.Holes;
+            Oth.clear();
+        }
+        return *this;
+    }
+    // Returns iterator of the first inserted item in O(1) amortized time.
+    iterator begin() {
+        return get_iterator(0).skip();
+    }
+    // Returns end iterator in O(1) time.
+    iterator end() {
+        return get_iterator(Entries.size());
+    }
+    // Returns constant iterator of the first inserted item in O(1) amortized time.
+    const_iterator begin() const {
+        return get_iterator(0).skip();
+    }
+    // Returns constant end iterator in O(1) time.
+    const_iterator end() const {
+        return get_iterator(Entries.size());
+    }
+    // Returns hash function in O(1) time.
+    Hash hash_function() const {
+        return HashFunction;
+    }
+    // Returns key equality function in O(1) time.
+    KeyEqual key_eq() const {
+        return Equal;
+    }
+    // Returns allocator in O(1) time.
+    Allocator get_allocator() const {
+        return Allocator(Entries.get_allocator());
+    }
+    // Appends copy of item if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(const value_type& Item) {
+        return emplace_key(Item.first, Item);
+    }
+    // Appends item by moving it if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(value_type&& Item) {
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Appends item constructed from Item, for example from a pair with mutable key, if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class P, class = typename std::enable_if<std::is_constructible<value_type, P&&>::value>::type>
+    std::pair<iterator, bool> insert(P&& Item) {
+        return emplace(std::forward<P>(Item));
+    }
+    // Appends item constructed from args if its key is absent in O(1) amortized time. Arguments which are a key and a value
+    // or one pair are constructed only on insertion, other arguments are first constructed into a temporary pair.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return emplace_decomposed(std::forward<Args>(args)...);
+    }
+    // Appends item constructed from key and args if the key is absent in O(1) amortized time, otherwise leaves args untouched.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const KeyType& Key, Args&&... args) {
+        return emplace_key(Key, std::piecewise_construct, std::forward_as_tuple(Key), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Appends item constructed from moved key and args if the key is absent in O(1) amortized time, otherwise leaves key and args untouched.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(KeyType&& Key, Args&&... args) {
+        return emplace_key(Key, std::piecewise_construct, std::forward_as_tuple(std::move(Key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    // Assigns Obj to item by key or appends a new item if the key is absent in O(1) amortized time. Assignment keeps the item place.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const KeyType& Key, M&& Obj) {
+        auto Result = try_emplace(Key, std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Assigns Obj to item by moved key or appends a new item if the key is absent in O(1) amortized time. Assignment keeps the item place.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(KeyType&& Key, M&& Obj) {
+        auto Result = try_emplace(std::move(Key), std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Erases item by key in O(1) amortized expected time and returns number of erased items.
+    // Invalidates iterators of the erased item, and of the others if holes are compacted.
+    size_t erase(const KeyType& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by key of type K comparable with KeyType in O(1) amortized expected time and returns number of erased items.
+    // Enabled only for transparent Hash and KeyEqual. Invalidates iterators of the erased item, and of the others if holes are compacted.
+    template<class K, class = TransparentKey<K>>
+    size_t erase(const K& Key) {
+        return erase_key(Key);
+    }
+    // Erases item by iterator in O(1) amortized expected time and returns iterator of the next item.
+    // Invalidates iterators of the erased item, and of the others if holes are compacted.
+    iterator erase(iterator Pos) {
+        size_t i = Pos.GetIndex();
+        return get_iterator(del(find_slot_of(i), i)).skip();
+    }
+    // Erases items in range [First, Last) in O(size + capacity) time and returns iterator of the item after them.
+    // Compacts holes, so invalidates iterators.
+    iterator erase(iterator First, iterator Last) {
+        size_t i = First.GetIndex(), j = Last.GetIndex();
+        if (i != j) {
+            for (size_t k = i; k != j; ++k) {
+                if (Entries[k].Live) {
+                    Entries[k].erase();
+                    ++Holes;
+                }
+            }
+            j = compact(Index.size(), j);
+        }
+        return get_iterator(j).skip();
+    }
+    // Returns iterator of item by key in O(probe length) time. If hash function is good, works in O(1) expected time.
+    iterator find(const KeyType& Key) {
+        return get_iterator(find_index(Key));
+    }
+    // Returns constant iterator of item by key in O(probe length) time. If hash function is good, works in O(1) expected time.
+    const_iterator find(const KeyType& Key) const {
+        return get_iterator(find_index(Key));
+    }
+    // Returns iterator of item by key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    iterator find(const K& Key) {
+        return get_iterator(find_index(Key));
+    }
+    // Returns constant iterator of item by key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const_iterator find(const K& Key) const {
+        return get_iterator(find_index(Key));
+    }
+    // Returns iterator of item by key with hash function value KeyHash computed by the caller in O(1) expected time.
+    iterator find(const KeyType& Key, size_t KeyHash) {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns constant iterator of item by key with hash function value KeyHash computed by the caller in O(1) expected time.
+    const_iterator find(const KeyType& Key, size_t KeyHash) const {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns iterator of item by key of type K with hash function value KeyHash computed by the caller in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    iterator find(const K& Key, size_t KeyHash) {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns constant iterator of item by key of type K with hash function value KeyHash computed by the caller in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const_iterator find(const K& Key, size_t KeyHash) const {
+        return get_iterator(find_index(Key, MurmurHashMixer()(KeyHash)));
+    }
+    // Returns number of items with key in O(1) expected time.
+    size_t count(const KeyType& Key) const {
+        return find_index(Key) != Entries.size();
+    }
+    // Returns number of items with key of type K comparable with KeyType in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    size_t count(const K& Key) const {
+        return find_index(Key) != Entries.size();
+    }
+    // Returns true if an item with key is stored in O(1) expected time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Returns true if an item with key of type K comparable with KeyType is stored in O(1) expected time.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    bool contains(const K& Key) const {
+        return count(Key) != 0;
+    }
+    // Clears items in O(size + capacity) time, keeping memory of items and table.
+    void clear() {
+        Entries.clear();
+        std::fill(Index.begin(), Index.end(), EmptyIndex);
+        Holes = 0;
+    }
+    // Returns item by key in O(1) amortized expected time. If no items stored by this key, appends a new item.
+    ValueType& operator[](const KeyType& Key) {
+        return try_emplace(Key).first->second;
+    }
+    // Returns item by key in O(1) amortized expected time. If no items stored by this key, appends a new item from moved key.
+    ValueType& operator[](KeyType&& Key) {
+        return try_emplace(std::move(Key)).first->second;
+    }
+    // Returns item by key in O(1) expected time. If no items stored by this key, throws out of range exception. If an exception is thrown, there are no changes in the container.
+    const ValueType& at(const KeyType& Key) const {
+        return get_value(Key);
+    }
+    // Returns item by key of type K comparable with KeyType in O(1) expected time. If no items stored by this key, throws out of range exception.
+    // Enabled only for transparent Hash and KeyEqual.
+    template<class K, class = TransparentKey<K>>
+    const ValueType& at(const K& Key) const {
+        return get_value(Key);
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Entries.size() - Holes;
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return size() == 0;
+    }
+    // Swaps contents with Oth in O(1) time.
+    void swap(OrderedHashMap& Oth) noexcept {
+        std::swap(HashFunction, Oth.HashFunction);
+        std::swap(Equal, Oth.Equal);
+        Entries.swap(Oth.Entries);
+        Index.swap(Oth.Index);
+        std::swap(MaxLoadFactor, Oth.MaxLoadFactor);
+        std::swap(Holes, Oth.Holes);
+    }
+    // Returns number of table slots in O(1) time.
+    size_t bucket_count() const {
+        return Index.size();
+    }
+    // Returns part of table slots storing item numbers in O(1) time.
+    float load_factor() const {
+        return Index.empty() ? 0 : static_cast<float>(size()) / Index.size();
+    }
+    // Returns maximum part of used table slots in O(1) time.
+    float max_load_factor() const {
+        return MaxLoadFactor;
+    }
+    // Sets maximum part of used table slots. Rebuilds table in O(size + capacity) time if it becomes dense.
+    // If the factor is not in (0, 1) interval, throws invalid argument exception.
+    void max_load_factor(float f) {
+        if (!(f > 0 && f < 1)) {
+            throw std::invalid_argument("incorrect load factor");
+        }
+        MaxLoadFactor = f;
+        if (size() > max_size_for(Index.size())) {
+            reindex(capacity_for(size()));
+        }
+    }
+    // Sets table capacity to at least n slots and at least enough for size() items in O(size + capacity) time.
+    // Does not move items, so iterators stay valid.
+    void rehash(size_t n) {
+        size_t c = capacity_for(size());
+        while (c < n) {
+            c *= 2;
+        }
+        if (c != Index.size()) {
+            reindex(c);
+        }
+    }
+    // Reserves memory for n items and sets table capacity enough for them in O(size + capacity) time,
+    // so that inserting them neither moves items nor rebuilds table. Invalidates iterators.
+    void reserve(size_t n) {
+        check_size(n + Holes);
+        Entries.reserve(n + Holes);
+        if (max_size_for(Index.size()) < n) {
+            reindex(capacity_for(n));
+        }
+    }
+
+  private:
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<entry_type> EntryAllocator;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<uint32_t> IndexAllocator;
+    // Mixes hash function of a key in O(1) time, so that low bits of the hash choose table slots well.
+    template<class K>
+    size_t get_hash(const K& Key) const {
+        return MurmurHashMixer()(HashFunction(Key));
+    }
+    // Throws length error exception if n items do not fit 32-bit item numbers.
+    static void check_size(size_t n) {
+        if (n >= EmptyIndex) {
+            throw std::length_error("too many items");
+        }
+    }
+    // Returns maximum number of items for table capacity n. At least one slot always stays empty.
+    size_t max_size_for(size_t n) const {
+        return n == 0 ? 0 : std::min(static_cast<size_t>(n * MaxLoadFactor), n - 1);
+    }
+    // Returns the smallest capacity fitting n items in O(log n) time.
+    size_t capacity_for(size_t n) const {
+        size_t c = MinCapacity;
+        while (max_size_for(c) < n) {
+            c *= 2;
+        }
+        return c;
+    }
+    // Grows table to fit items of [first, last) range if its length is known without iterating, otherwise does nothing.
+    template<class Iterator>
+    void presize(Iterator first, Iterator last) {
+        if constexpr (std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>::value) {
+            reserve(static_cast<size_t>(std::distance(first, last)));
+        }
+    }
+    // Returns iterator of item number i in O(1) time.
+    iterator get_iterator(size_t i) {
+        return iterator(Entries.data(), i, Entries.size());
+    }
+    // Returns constant iterator of item number i in O(1) time.
+    const_iterator get_iterator(size_t i) const {
+        return const_iterator(Entries.data(), i, Entries.size());
+    }
+    // Returns table slot holding number of item by key with mixed hash h, or capacity if there is no such item.
+    // Works in O(probe length) time.
+    template<class K>
+    size_t find_slot(const K& Key, size_t h) const {
+        if (Entries.empty()) {
+            return Index.size();
+        }
+        size_t Mask = Index.size() - 1;
+        for (size_t i = h & Mask;; i = (i + 1) & Mask) {
+            uint32_t e = Index[i];
+            if (e == EmptyIndex) {
+                return Index.size();
+            }
+            if (Entries[e].Slot.hash_matches(h) && Equal(Entries[e].Slot.Value.first, Key)) {
+                return i;
+            }
+        }
+    }
+    // Returns table slot holding item number e in O(probe length) time. The item must be stored.
+    size_t find_slot_of(size_t e) const {
+        size_t Mask = Index.size() - 1;
+        size_t i = Entries[e].Slot.hash() & Mask;
+        while (Index[i] != e) {
+            i = (i + 1) & Mask;
+        }
+        return i;
+    }
+    // Returns number of item by key or size if there is no such item. Works in O(probe length) time.
+    template<class K>
+    size_t find_index(const K& Key) const {
+        if (Entries.empty()) {
+            return 0;
+        }
+        return find_index(Key, get_hash(Key));
+    }
+    // Returns number of item by key with mixed hash h or size if there is no such item. Works in O(probe length) time.
+    template<class K>
+    size_t find_index(const K& Key, size_t h) const {
+        size_t i = find_slot(Key, h);
+        return i == Index.size() ? Entries.size() : Index[i];
+    }
+    // Returns item by key or throws out of range exception if there is no such item. Works in O(probe length) time.
+    template<class K>
+    const ValueType& get_value(const K& Key) const {
+        size_t i = find_index(Key);
+        if (i == Entries.size()) {
+            throw std::out_of_range("incorrect key");
+        }
+        return Entries[i].Slot.Value.second;
+    }
+    // Erases item by key and returns number of erased items. Works in O(probe length + number of later items) time.
+    template<class K>
+    size_t erase_key(const K& Key) {
+        if (Entries.empty()) {
+            return 0;
+        }
+        size_t i = find_slot(Key, get_hash(Key));
+        if (i == Index.size()) {
+            return 0;
+        }
+        del(i, Index[i]);
+        return 1;
+    }
+    // Returns table slot holding item number by key and true, or the empty slot where number of a new item
+    // with this key should be stored and false. Works in O(probe length) expected time, hash function is called once and
+    // h is set to its mixed value. If one more item would make table dense, the table grows and holes are compacted beforehand,
+    // so the slot stays valid. So are holes if the array has no room for one more item number.
+    std::pair<size_t, bool> find_or_prepare_insert(const KeyType& Key, size_t& h) {
+        h = get_hash(Key);
+        if (size() + 1 > max_size_for(Index.size()) || Entries.size() + 1 >= EmptyIndex) {
+            size_t i = find_slot(Key, h);
+            if (i != Index.size()) {
+                return {i, true};
+            }
+            check_size(size() + 1);
+            compact(std::max(Index.size(), capacity_for(size() + 1)));
+        }
+        size_t Mask = Index.size() - 1;
+        for (size_t i = h & Mask;; i = (i + 1) & Mask) {
+            uint32_t e = Index[i];
+            if (e == EmptyIndex) {
+                return {i, false};
+            }
+            if (Entries[e].Slot.hash_matches(h) && Equal(Entries[e].Slot.Value.first, Key)) {
+                return {i, true};
+            }
+        }
+    }
+    // Finds key and if it is absent, appends item constructed from args in O(1) amortized expected time.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_key(const KeyType& Key, Args&&... args) {
+        size_t h;
+        auto Place = find_or_prepare_insert(Key, h);
+        if (Place.second) {
+            return {get_iterator(Index[Place.first]), false};
+        }
+        Entries.emplace_back(std::in_place, std::forward<Args>(args)...);
+        Entries.back().Slot.set_hash(h);
+        Index[Place.first] = static_cast<uint32_t>(Entries.size() - 1);
+        return {get_iterator(Entries.size() - 1), true};
+    }
+    // Emplaces item constructed from key and value, looking the key up before construction.
+    template<class K, class V>
+    std::pair<iterator, bool> emplace_decomposed(K&& k, V&& v) {
+        if constexpr (std::is_same<typename std::decay<K>::type, KeyType>::value) {
+            return emplace_key(k, std::forward<K>(k), std::forward<V>(v));
+        } else {
+            KeyType Key(std::forward<K>(k));
+            return emplace_key(Key, std::move(Key), std::forward<V>(v));
+        }
+    }
+    // Emplaces item constructed from members of pair Item.
+    template<class P, class = decltype(std::declval<P&>().first)>
+    std::pair<iterator, bool> emplace_decomposed(P&& Item) {
+        return emplace_decomposed(std::forward<P>(Item).first, std::forward<P>(Item).second);
+    }
+    // Emplaces item constructed from arbitrary arguments through a temporary pair.
+    template<class... Args>
+    std::pair<iterator, bool> emplace_decomposed(Args&&... args) {
+        std::pair<KeyType, ValueType> Item(std::forward<Args>(args)...);
+        return emplace_key(Item.first, std::move(Item));
+    }
+    // Erases item number e whose number is kept in table slot i in O(probe length) amortized time.
+    // Later numbers in the probe run are shifted back into the freed slot, so probes need no deleted marks.
+    // The item leaves a hole, or if it is the last one, trailing holes are dropped instead. Holes are compacted once they
+    // outnumber items. Returns number of the entry following the erased item after that.
+    size_t del(size_t i, size_t e) {
+        size_t Mask = Index.size() - 1;
+        for (size_t j = (i + 1) & Mask; Index[j] != EmptyIndex; j = (j + 1) & Mask) {
+            size_t Home = Entries[Index[j]].Slot.hash() & Mask;
+            if (((j - Home) & Mask) >= ((j - i) & Mask)) {
+                Index[i] = Index[j];
+                i = j;
+            }
+        }
+        Index[i] = EmptyIndex;
+        Entries[e].erase();
+        ++Holes;
+        if (e + 1 == Entries.size()) {
+            while (!Entries.empty() && !Entries.back().Live) {
+                Entries.pop_back();
+                --Holes;
+            }
+            return Entries.size();
+        }
+        return Holes > size() ? compact(Index.size(), e + 1) : e + 1;
+    }
+    // Moves items back over holes, keeping their order, and rebuilds table of capacity n in O(size + holes + n) time.
+    // Returns the new number of the first item at or after entry number e.
+    size_t compact(size_t n, size_t e = 0) {
+        if (Holes != 0) {
+            size_t j = 0;
+            for (size_t k = 0; k != Entries.size(); ++k) {
+                if (k == e) {
+                    e = j;
+                }
+                if (Entries[k].Live) {
+                    if (j != k) {
+                        Entries[j] = std::move(Entries[k]);
+                    }
+                    ++j;
+                }
+            }
+            if (e > j) {
+                e = j;
+            }
+            Entries.erase(Entries.begin() + j, Entries.end());
+            Holes = 0;
+        }
+        reindex(n);
+        return e;
+    }
+    // Rebuilds table of capacity n from stored hashes of items in O(size + holes + n) time. n must be a power of two.
+    void reindex(size_t n) {
+        std::vector<uint32_t, IndexAllocator> NewIndex(n, EmptyIndex, Index.get_allocator());
+        size_t Mask = n - 1;
+        for (size_t k = 0; k != Entries.size(); ++k) {
+            if (Entries[k].Live) {
+                size_t i = Entries[k].Slot.hash() & Mask;
+                while (NewIndex[i] != EmptyIndex) {
+                    i = (i + 1) & Mask;
+                }
+                NewIndex[i] = static_cast<uint32_t>(k);
+            }
+        }
+        Index.swap(NewIndex);
+    }
+    Hash HashFunction;
+    KeyEqual Equal;
+    std::vector<entry_type, EntryAllocator> Entries;
+    std::vector<uint32_t, IndexAllocator> Index;
+    float MaxLoadFactor = DefaultMaxLoadFactor;
+    // Number of holes left in Entries by erased items.
+    size_t Holes = 0;
+};
+
+// Insertion ordered hash table iterator implemented by storing the item array and item number.
+// Skips holes of erased items. Iteration is a sweep over the array in O(size + holes) time, holes never outnumbering items.
+template<class EntryType>
+class OrderedHashMapIterator {
+  public:
+    typedef typename EntryType::value_type ValueType;
     // Default constructor.
-    HashMap() {
+    OrderedHashMapIterator() {}
+    // Constructor by item array, item number and array size.
+    OrderedHashMapIterator(EntryType* e, size_t i, size_t n) {
+        Entries = e;
+        Index = i;
+        End = n;
+    }
+    // Returns true if iterator is equal to Oth in O(1) time.
+    bool operator==(const OrderedHashMapIterator &Oth) const {
+        return Index == Oth.Index && Entries == Oth.Entries;
+    }
+    // Returns true if iterator is not equal to Oth in O(1) time.
+    bool operator!=(const OrderedHashMapIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns number of the item in the array, holes of erased items included, in O(1) time.
+    size_t GetIndex() const {
+        return Index;
+    }
+    // Returns item object in O(1) time.
+    ValueType& operator*() const {
+        return Entries[Index].Slot.Value;
+    }
+    // Returns item reference in O(1) time.
+    ValueType* operator->() const {
+        return &Entries[Index].Slot.Value;
+    }
+    // Moves iterator over holes of erased items to the nearest item or the end. Works in O(skipped holes) time.
+    OrderedHashMapIterator& skip() {
+        while (Index < End && !Entries[Index].Live) {
+            ++Index;
+        }
+        return *this;
+    }
+    // Moves iterator to next item and returns it in O(1) amortized time.
+    OrderedHashMapIterator& operator++() {
+        ++Index;
+        return skip();
+    }
+    // Moves iterator to next item and returns its previous state in O(1) amortized time.
+    OrderedHashMapIterator operator++(int) {
+        OrderedHashMapIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    EntryType* Entries = nullptr;
+    size_t Index = 0;
+    size_t End = 0;
+};
+
+// Constant insertion ordered hash table iterator implemented by storing the item array and item number.
+// Skips holes of erased items. Iteration is a sweep over the array in O(size + holes) time, holes never outnumbering items.
+template<class EntryType>
+class OrderedHashMapConstIterator {
+  public:
+    typedef typename EntryType::value_type ValueType;
+    // Default constructor.
+    OrderedHashMapConstIterator() {}
+    // Constructor by item array, item number and array size.
+    OrderedHashMapConstIterator(const EntryType* e, size_t i, size_t n) {
+        Entries = e;
+        Index = i;
+        End = n;
+    }
+    // Returns true if constant iterator is equal to Oth in O(1) time.
+    bool operator==(const OrderedHashMapConstIterator &Oth) const {
+        return Index == Oth.Index && Entries == Oth.Entries;
+    }
+    // Returns true if constant iterator is not equal to Oth in O(1) time.
+    bool operator!=(const OrderedHashMapConstIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns number of the item in the array, holes of erased items included, in O(1) time.
+    size_t GetIndex() const {
+        return Index;
+    }
+    // Returns constant item object in O(1) time.
+    const ValueType& operator*() const {
+        return Entries[Index].Slot.Value;
+    }
+    // Returns constant item reference in O(1) time.
+    const ValueType* operator->() const {
+        return &Entries[Index].Slot.Value;
+    }
+    // Moves constant iterator over holes of erased items to the nearest item or the end. Works in O(skipped holes) time.
+    OrderedHashMapConstIterator& skip() {
+        while (Index < End && !Entries[Index].Live) {
+            ++Index;
+        }
+        return *this;
+    }
+    // Moves constant iterator to next item and returns it in O(1) amortized time.
+    OrderedHashMapConstIterator& operator++() {
+        ++Index;
+        return skip();
+    }
+    // Moves constant iterator to next item and returns its previous state in O(1) amortized time.
+    OrderedHashMapConstIterator operator++(int) {
+        OrderedHashMapConstIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    const EntryType* Entries = nullptr;
+    size_t Index = 0;
+    size_t End = 0;
+};
+
+// Returns the key marking empty slots of IntHashMap: the key with all bits set.
+template<class KeyType>
+constexpr KeyType int_hash_map_empty_key() {
+    return static_cast<KeyType>(~static_cast<typename std::make_unsigned<KeyType>::type>(0));
+}
+
+// Open addressing hash table for integral keys storing keys and values in separate arrays.
+// Probes compare only keys, so a lookup touches the value array once, on a hit. Empty slots are marked by EmptyKey,
+// the key with all bits set, so there is no per-slot metadata. An item with EmptyKey itself is kept in a spare slot after the others.
+// Keys are mixed with a per-table random seed, hashed by Mixer and probed linearly. Probes never wrap around: ProbeLimit slots
+// follow the last home slot, and the table grows when a key finds no free slot within that distance, so erasing shifts later keys
+// of the run back without deleted marks and erasing while iterating visits every remaining item once. Such growth stops at four times
+// the capacity needed for the load factor; past it the table is rehashed with a new seed, so keys colliding under one seed can not exhaust memory.
+// Capacity is a power of two. Items are not stored as pairs, so iterators return pairs of references.
+// Allocator is rebound for keys and values.
+template<class KeyType, class ValueType, class Mixer = MurmurHashMixer, class Allocator = std::allocator<std::pair<const KeyType, ValueType>>>
+class IntHashMap {
+    static_assert(std::is_integral<KeyType>::value && !std::is_same<KeyType, bool>::value, "IntHashMap needs integral keys");
+  public:
+    static constexpr size_t MinCapacity = 16;
+    static constexpr float DefaultMaxLoadFactor = 0.5f;
+    // Key marking empty slots.
+    static constexpr KeyType EmptyKey = int_hash_map_empty_key<KeyType>();
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    typedef IntHashMapIterator<KeyType, ValueType> iterator;
+    typedef IntHashMapConstIterator<KeyType, ValueType> const_iterator;
+    typedef Allocator allocator_type;
+    // Default constructor. Does not allocate memory.
+    IntHashMap() {
+        initialize();
+    }
+    // Constructor for begin and end iterators. Sizes table once if iterators are random access.
+    template<class Iterator>
+    IntHashMap(Iterator first, Iterator last) {
         initialize();
+        presize(first, last);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for begin and end iterators with expected number of items. Sizes table once for SizeHint items.
+    template<class Iterator>
+    IntHashMap(Iterator first, Iterator last, size_t SizeHint) {
+        initialize();
+        reserve(SizeHint);
+        for (auto i = first; i != last; ++i) {
+            insert(*i);
+        }
+    }
+    // Constructor for initializer list.
+    IntHashMap(std::initializer_list<std::pair<KeyType, ValueType>> List) {
+        initialize();
+        reserve(List.size());
+        for (auto& i : List) {
+            insert(i);
+        }
+    }
+    // Default constructor with allocator.
+    explicit IntHashMap(const Allocator& Alloc): Alloc(Alloc), Keys(KeyAllocator(Alloc)) {
+        initialize();
+    }
+    // Copy constructor. Copies every item into the slot of the same number in O(capacity) time.
+    IntHashMap(const IntHashMap& Oth)
+        : Alloc(AllocatorTraits::select_on_container_copy_construction(Oth.Alloc)), Keys(KeyAllocator(Alloc)) {
+        initialize();
+        copy_from(Oth);
+    }
+    // Move constructor in O(1) time. Oth is left empty.
+    IntHashMap(IntHashMap&& Oth) noexcept: Alloc(Oth.Alloc), Keys(KeyAllocator(Alloc)) {
+        initialize();
+        swap(Oth);
+    }
+    // Destroys every item and frees memory in O(capacity) time.
+    ~IntHashMap() {
+        destroy();
+    }
+    // Returns begin iterator in O(capacity) time.
+    iterator begin() {
+        return get_iterator(0).skip();
+    }
+    // Returns end iterator in O(1) time.
+    iterator end() {
+        return get_iterator(end_index());
+    }
+    // Returns constant begin iterator in O(capacity) time.
+    const_iterator begin() const {
+        return get_iterator(0).skip();
+    }
+    // Returns constant end iterator in O(1) time.
+    const_iterator end() const {
+        return get_iterator(end_index());
+    }
+    // Returns allocator in O(1) time.
+    Allocator get_allocator() const {
+        return Allocator(Alloc);
+    }
+    // Inserts copy of item if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(const value_type& Item) {
+        return try_emplace(Item.first, Item.second);
+    }
+    // Inserts item by moving its value if its key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    std::pair<iterator, bool> insert(value_type&& Item) {
+        return try_emplace(Item.first, std::move(Item.second));
+    }
+    // Constructs item from a key and a value or from one pair if the key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return emplace_decomposed(std::forward<Args>(args)...);
+    }
+    // Constructs value from args if the key is absent in O(1) amortized time, otherwise leaves args untouched.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(KeyType Key, Args&&... args) {
+        auto Place = find_or_prepare_insert(Key);
+        if (!Place.second) {
+            AllocatorTraits::construct(Alloc, Values + Place.first, std::forward<Args>(args)...);
+            if (Place.first == Terminal) {
+                HasEmptyKey = true;
+            } else {
+                Keys[Place.first] = Key;
+            }
+            ++Sz;
+        }
+        return {get_iterator(Place.first), !Place.second};
+    }
+    // Assigns Obj to item by key or inserts a new item if the key is absent in O(1) amortized time.
+    // Returns iterator of the item with this key and true if insertion took place. May invalidate iterators.
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(KeyType Key, M&& Obj) {
+        auto Result = try_emplace(Key, std::forward<M>(Obj));
+        if (!Result.second) {
+            Result.first->second = std::forward<M>(Obj);
+        }
+        return Result;
+    }
+    // Erases item by key in O(probe length) time and returns number of erased items.
+    // Later keys of the probe run may move back, so iterators of other items may be invalidated.
+    size_t erase(KeyType Key) {
+        size_t i = find_index(Key);
+        if (i == end_index()) {
+            return 0;
+        }
+        del(i);
+        return 1;
+    }
+    // Erases item by iterator in O(probe length) time and returns iterator of the next item.
+    // Items moved back into the erased slot come from later slots, so erasing while iterating visits every remaining item once.
+    iterator erase(iterator Pos) {
+        size_t i = Pos.GetIndex();
+        del(i);
+        return i == Terminal ? end() : get_iterator(i).skip();
+    }
+    // Erases items in range [First, Last) in O(slots in range) expected time and returns iterator of the item after them.
+    // Keys of the range are collected first, since erasing may move items from after the range into it.
+    iterator erase(iterator First, iterator Last) {
+        std::vector<KeyType> Erased;
+        for (; First != Last; ++First) {
+            Erased.push_back(First->first);
+        }
+        bool AtEnd = Last == end();
+        KeyType Next = AtEnd ? KeyType() : Last->first;
+        for (KeyType Key : Erased) {
+            erase(Key);
+        }
+        return AtEnd ? end() : find(Next);
+    }
+    // Returns iterator of item by key in O(probe length) time. If keys are mixed well, works in O(1) expected time.
+    iterator find(KeyType Key) {
+        return get_iterator(find_index(Key));
+    }
+    // Returns constant iterator of item by key in O(probe length) time. If keys are mixed well, works in O(1) expected time.
+    const_iterator find(KeyType Key) const {
+        return get_iterator(find_index(Key));
+    }
+    // Returns number of items with key in O(1) expected time.
+    size_t count(KeyType Key) const {
+        return find_index(Key) != end_index();
+    }
+    // Returns true if an item with key is stored in O(1) expected time.
+    bool contains(KeyType Key) const {
+        return count(Key) != 0;
+    }
+    // Destroys every item in O(capacity) time, keeping the table.
+    void clear() {
+        for (size_t i = 0; i != Terminal; ++i) {
+            if (Keys[i] != EmptyKey) {
+                AllocatorTraits::destroy(Alloc, Values + i);
+                Keys[i] = EmptyKey;
+            }
+        }
+        if (HasEmptyKey) {
+            AllocatorTraits::destroy(Alloc, Values + Terminal);
+            HasEmptyKey = false;
+        }
+        Sz = 0;
+    }
+    // Assigns *this to Oth. Copies items into a new table with the allocator of *this and then swaps tables.
+    // Works in O(Oth.capacity + *this.capacity) time. If an exception is thrown, there are no changes in the container.
+    IntHashMap& operator=(const IntHashMap& Oth) {
+        if (this != &Oth) {
+            IntHashMap Copy(Alloc);
+            Copy.copy_from(Oth);
+            swap(Copy);
+        }
+        return *this;
+    }
+    // Moves Oth to *this in O(*this.capacity) time. Oth is left empty.
+    IntHashMap& operator=(IntHashMap&& Oth) noexcept {
+        if (this != &Oth) {
+            destroy();
+            initialize();
+            swap(Oth);
+        }
+        return *this;
+    }
+    // Returns item by key in O(1) amortized expected time. If no items stored by this key, creates a new item.
+    ValueType& operator[](KeyType Key) {
+        return try_emplace(Key).first->second;
+    }
+    // Returns item by key in O(1) expected time. If no items stored by this key, throws out of range exception. If an exception is thrown, there are no changes in the container.
+    const ValueType& at(KeyType Key) const {
+        size_t i = find_index(Key);
+        if (i == end_index()) {
+            throw std::out_of_range("incorrect key");
+        }
+        return Values[i];
+    }
+    // Returns number of stored items in O(1) time.
+    size_t size() const {
+        return Sz;
+    }
+    // Returns true if the container does not store any item in O(1) time.
+    bool empty() const {
+        return Sz == 0;
+    }
+    // Swaps contents with Oth in O(1) time.
+    void swap(IntHashMap& Oth) noexcept {
+        std::swap(Alloc, Oth.Alloc);
+        std::swap(Keys, Oth.Keys);
+        std::swap(Values, Oth.Values);
+        std::swap(Capacity, Oth.Capacity);
+        std::swap(Terminal, Oth.Terminal);
+        std::swap(Sz, Oth.Sz);
+        std::swap(HasEmptyKey, Oth.HasEmptyKey);
+        std::swap(MaxLoadFactor, Oth.MaxLoadFactor);
+        std::swap(Seed, Oth.Seed);
+    }
+    // Returns number of home slots in O(1) time.
+    size_t bucket_count() const {
+        return Capacity;
+    }
+    // Returns part of home slots storing items in O(1) time.
+    float load_factor() const {
+        return Capacity == 0 ? 0 : static_cast<float>(Sz) / Capacity;
+    }
+    // Returns maximum part of home slots storing items in O(1) time.
+    float max_load_factor() const {
+        return MaxLoadFactor;
+    }
+    // Sets maximum part of home slots storing items. Rehashes table in O(size + capacity) time if it becomes dense.
+    // If the factor is not in (0, 1) interval, throws invalid argument exception.
+    void max_load_factor(float f) {
+        if (!(f > 0 && f < 1)) {
+            throw std::invalid_argument("incorrect load factor");
+        }
+        MaxLoadFactor = f;
+        if (Sz > max_size_for(Capacity)) {
+            resize(capacity_for(Sz));
+        }
+    }
+    // Sets capacity to at least n home slots and at least enough for size() items in O(size + capacity) time. Invalidates iterators.
+    void rehash(size_t n) {
+        size_t c = capacity_for(Sz);
+        while (c < n) {
+            c *= 2;
+        }
+        if (c != Capacity) {
+            resize(c);
+        }
+    }
+    // Sets capacity enough for n items in O(size + capacity) time, so that inserting them usually does not resize table.
+    // Invalidates iterators.
+    void reserve(size_t n) {
+        if (max_size_for(Capacity) < n) {
+            resize(capacity_for(n));
+        }
+    }
+
+  private:
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<ValueType> ValueAllocator;
+    typedef std::allocator_traits<ValueAllocator> AllocatorTraits;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<KeyType> KeyAllocator;
+    // Number of seeds resize tries for keys not fitting the probe limit before it gives up.
+    static constexpr size_t MaxSeeds = 8;
+    // Makes table of zero capacity without allocating. Key array stays empty; iterators read the static EmptyKey as the terminal key.
+    void initialize() {
+        Keys.clear();
+        Values = nullptr;
+        Capacity = 0;
+        Terminal = 0;
+        Sz = 0;
+        HasEmptyKey = false;
+    }
+    // Returns greatest distance from its home slot to the slot of a key for capacity n in O(1) time.
+    static size_t probe_limit(size_t n) {
+        return n == 0 ? 0 : 16 + 4 * count_trailing_zeros(n);
+    }
+    // Returns maximum number of items for capacity n.
+    size_t max_size_for(size_t n) const {
+        return static_cast<size_t>(n * MaxLoadFactor);
+    }
+    // Returns the smallest capacity fitting n items in O(log n) time.
+    size_t capacity_for(size_t n) const {
+        size_t c = MinCapacity;
+        while (max_size_for(c) < n) {
+            c *= 2;
+        }
+        return c;
+    }
+    // Grows table to fit items of [first, last) range if its length is known without iterating, otherwise does nothing.
+    template<class Iterator>
+    void presize(Iterator first, Iterator last) {
+        if constexpr (std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>::value) {
+            reserve(static_cast<size_t>(std::distance(first, last)));
+        }
+    }
+    // Returns home slot of key for nonzero capacity n and seed s in O(1) time.
+    static size_t home(KeyType Key, size_t n, size_t s) {
+        return Mixer()(static_cast<size_t>(Key) ^ s) & (n - 1);
+    }
+    // Returns home slot of key in O(1) time. There must be at least one home slot.
+    size_t home(KeyType Key) const {
+        return home(Key, Capacity, Seed);
+    }
+    // Returns slot number of the end iterator: after the spare slot if it stores an item, the spare slot otherwise.
+    size_t end_index() const {
+        return HasEmptyKey ? Terminal + 1 : Terminal;
+    }
+    // Returns key array in O(1) time: the static EmptyKey as the only terminal key while capacity is zero.
+    const KeyType* key_data() const {
+        return Keys.empty() ? &EmptyKey : Keys.data();
+    }
+    // Returns iterator for slot of number i in O(1) time.
+    iterator get_iterator(size_t i) {
+        return iterator(key_data(), Values, i, Terminal);
+    }
+    // Returns constant iterator for slot of number i in O(1) time.
+    const_iterator get_iterator(size_t i) const {
+        return const_iterator(key_data(), Values, i, Terminal);
+    }
+    // Returns slot number of item by key or end index if there is no such item. Works in O(probe length) time
+    // and reads only keys: the terminal empty key ends every probe.
+    size_t find_index(KeyType Key) const {
+        if (Key == EmptyKey) {
+            return HasEmptyKey ? Terminal : end_index();
+        }
+        if (Sz == 0) {
+            return end_index();
+        }
+        for (size_t i = home(Key);; ++i) {
+            if (Keys[i] == Key) {
+                return i;
+            }
+            if (Keys[i] == EmptyKey) {
+                return end_index();
+            }
+        }
+    }
+    // Returns slot number of item by key and true, or number of the free slot where a value for this key should be
+    // constructed and false. Works in O(probe length) expected time. If the item would break the load limit or
+    // the free slot is beyond the probe limit, the table grows or changes its seed beforehand, so the slot stays valid.
+    // Throws length error exception if the key fits no seed; then there are no changes in the items.
+    std::pair<size_t, bool> find_or_prepare_insert(KeyType Key) {
+        if (Key == EmptyKey) {
+            if (Capacity == 0) {
+                resize(MinCapacity);
+            }
+            return {Terminal, HasEmptyKey};
+        }
+        for (size_t Seeds = 1;;) {
+            if (Capacity != 0) {
+                size_t Home = home(Key);
+                size_t i = Home;
+                for (; Keys[i] != EmptyKey; ++i) {
+                    if (Keys[i] == Key) {
+                        return {i, true};
+                    }
+                }
+                if (i - Home < probe_limit(Capacity) && Sz + 1 <= max_size_for(Capacity)) {
+                    return {i, false};
+                }
+            }
+            if (Capacity == 0 || Sz + 1 > max_size_for(Capacity)) {
+                resize(capacity_for(Sz + 1));
+            } else if (Capacity * 2 <= max_capacity_for(Sz + 1)) {
+                resize(Capacity * 2);
+            } else if (Seeds++ != MaxSeeds) {
+                resize(Capacity, true);
+            } else {
+                throw std::length_error("incorrect key");
+            }
+        }
+    }
+    // Emplaces item constructed from key and value.
+    template<class K, class V>
+    std::pair<iterator, bool> emplace_decomposed(K&& k, V&& v) {
+        return try_emplace(static_cast<KeyType>(k), std::forward<V>(v));
+    }
+    // Emplaces item constructed from members of pair Item.
+    template<class P, class = decltype(std::declval<P&>().first)>
+    std::pair<iterator, bool> emplace_decomposed(P&& Item) {
+        return try_emplace(static_cast<KeyType>(Item.first), std::forward<P>(Item).second);
+    }
+    // Moves value of slot From into free slot To and destroys it in O(1) time.
+    void relocate(size_t To, size_t From) {
+        AllocatorTraits::construct(Alloc, Values + To, std::move(Values[From]));
+        AllocatorTraits::destroy(Alloc, Values + From);
+    }
+    // Destroys item in slot of number i in O(probe length) time. Later keys of the probe run whose home slot
+    // is not after the freed slot move back into it, so probes need no deleted marks.
+    void del(size_t i) {
+        AllocatorTraits::destroy(Alloc, Values + i);
+        --Sz;
+        if (i == Terminal) {
+            HasEmptyKey = false;
+            return;
+        }
+        for (size_t j = i + 1; Keys[j] != EmptyKey; ++j) {
+            if (home(Keys[j]) <= i) {
+                Keys[i] = Keys[j];
+                relocate(i, j);
+                i = j;
+            }
+        }
+        Keys[i] = EmptyKey;
+    }
+    // Returns the greatest capacity that probe limit overflows may grow table of n items to.
+    // Beyond it the seed changes instead, so colliding keys can not make the table grow without bound.
+    size_t max_capacity_for(size_t n) const {
+        return capacity_for(n) << 2;
+    }
+    // Fills NewKeys with keys placed into table of capacity n and seed s in O(size + n) time.
+    // Returns false if some key finds no free slot within the probe limit.
+    bool place_keys(std::vector<KeyType, KeyAllocator>& NewKeys, size_t n, size_t s) const {
+        NewKeys.assign(n + probe_limit(n) + 1, EmptyKey);
+        for (size_t i = 0; i != Terminal; ++i) {
+            if (Keys[i] != EmptyKey) {
+                size_t Home = home(Keys[i], n, s);
+                size_t j = Home;
+                while (NewKeys[j] != EmptyKey) {
+                    ++j;
+                }
+                if (j - Home >= probe_limit(n)) {
+                    return false;
+                }
+                NewKeys[j] = Keys[i];
+            }
+        }
+        return true;
+    }
+    // Changes capacity to n, or to a greater power of two if keys do not fit the probe limit, in O(size + n) expected time.
+    // Past max_capacity_for(size()) a new seed is drawn instead of doubling; so is it at once if Reseed is true.
+    // Throws length error exception if keys fit no seed; then there are no changes in the container.
+    // Keys are placed first, then values are moved, not copied, into slots of their keys. n must be a power of two.
+    void resize(size_t n, bool Reseed = false) {
+        std::vector<KeyType, KeyAllocator> NewKeys(Keys.get_allocator());
+        size_t Limit = std::max(n, max_capacity_for(Sz));
+        size_t NewSeed = Reseed ? hash_map_random_seed() : Seed;
+        for (size_t Seeds = 1; !place_keys(NewKeys, n, NewSeed);) {
+            if (n < Limit) {
+                n *= 2;
+            } else if (Seeds++ == MaxSeeds) {
+                throw std::length_error("incorrect keys");
+            } else {
+                NewSeed = hash_map_random_seed();
+            }
+        }
+        ValueType* NewValues = AllocatorTraits::allocate(Alloc, n + probe_limit(n) + 1);
+        size_t NewTerminal = n + probe_limit(n);
+        for (size_t i = 0; i != Terminal; ++i) {
+            if (Keys[i] != EmptyKey) {
+                size_t j = home(Keys[i], n, NewSeed);
+                while (NewKeys[j] != Keys[i]) {
+                    ++j;
+                }
+                AllocatorTraits::construct(Alloc, NewValues + j, std::move(Values[i]));
+                AllocatorTraits::destroy(Alloc, Values + i);
+            }
+        }
+        if (HasEmptyKey) {
+            AllocatorTraits::construct(Alloc, NewValues + NewTerminal, std::move(Values[Terminal]));
+            AllocatorTraits::destroy(Alloc, Values + Terminal);
+        }
+        if (Values != nullptr) {
+            AllocatorTraits::deallocate(Alloc, Values, Terminal + 1);
+        }
+        Keys.swap(NewKeys);
+        Values = NewValues;
+        Capacity = n;
+        Terminal = NewTerminal;
+        Seed = NewSeed;
+    }
+    // Copies items of Oth into the same slot numbers of an empty table in O(Oth.capacity) time.
+    // A key is stored only after its value is constructed, so if a copy throws, the items copied so far
+    // are destroyed and the table is left empty.
+    void copy_from(const IntHashMap& Oth) {
+        MaxLoadFactor = Oth.MaxLoadFactor;
+        Seed = Oth.Seed;
+        if (Oth.Capacity == 0) {
+            return;
+        }
+        try {
+            Keys.assign(Oth.Keys.size(), EmptyKey);
+            Values = AllocatorTraits::allocate(Alloc, Oth.Terminal + 1);
+            Capacity = Oth.Capacity;
+            Terminal = Oth.Terminal;
+            for (size_t i = 0; i != Terminal; ++i) {
+                if (Oth.Keys[i] != EmptyKey) {
+                    AllocatorTraits::construct(Alloc, Values + i, Oth.Values[i]);
+                    Keys[i] = Oth.Keys[i];
+                    ++Sz;
+                }
+            }
+            if (Oth.HasEmptyKey) {
+                AllocatorTraits::construct(Alloc, Values + Terminal, Oth.Values[Terminal]);
+                HasEmptyKey = true;
+                ++Sz;
+            }
+        } catch (...) {
+            destroy();
+            initialize();
+            throw;
+        }
+    }
+    // Destroys every item and frees values in O(capacity) time.
+    void destroy() {
+        clear();
+        if (Values != nullptr) {
+            AllocatorTraits::deallocate(Alloc, Values, Terminal + 1);
+        }
+    }
+    ValueAllocator Alloc;
+    // Capacity home slots, then probe limit overflow slots, then the terminal slot whose key is always empty. Empty while capacity is zero.
+    std::vector<KeyType, KeyAllocator> Keys;
+    // Values of items in slots of the same numbers. The terminal slot keeps the value of key EmptyKey.
+    ValueType* Values = nullptr;
+    size_t Capacity = 0;
+    size_t Terminal = 0;
+    size_t Sz = 0;
+    bool HasEmptyKey = false;
+    float MaxLoadFactor = DefaultMaxLoadFactor;
+    // Mixed into keys before hashing, so that colliding keys can not be chosen in advance.
+    size_t Seed = hash_map_random_seed();
+};
+
+// Integral key hash table iterator implemented by storing key and value arrays and slot number.
+// Dereferencing returns a pair of references to the key and the value. Skips empty slots, guarantees iteration in O(capacity) time.
+template<class KeyType, class ValueType>
+class IntHashMapIterator {
+  public:
+    typedef std::pair<const KeyType&, ValueType&> Reference;
+    // Pointer-like holder of a reference pair returned by operator->().
+    struct Pointer {
+        Reference Item;
+        const Reference* operator->() const {
+            return &Item;
+        }
+    };
+    // Default constructor.
+    IntHashMapIterator() {}
+    // Constructor by key and value arrays, slot number and number of the terminal slot.
+    IntHashMapIterator(const KeyType* k, ValueType* v, size_t i, size_t t) {
+        Keys = k;
+        Values = v;
+        Index = i;
+        Terminal = t;
+    }
+    // Returns true if iterator is equal to Oth in O(1) time.
+    bool operator==(const IntHashMapIterator &Oth) const {
+        return Index == Oth.Index && Keys == Oth.Keys;
+    }
+    // Returns true if iterator is not equal to Oth in O(1) time.
+    bool operator!=(const IntHashMapIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns slot number in O(1) time.
+    size_t GetIndex() const {
+        return Index;
+    }
+    // Returns pair of references to key and value in O(1) time.
+    Reference operator*() const {
+        return Reference(Keys[Index], Values[Index]);
+    }
+    // Returns holder of pair of references to key and value in O(1) time.
+    Pointer operator->() const {
+        return Pointer{**this};
+    }
+    // Moves iterator to the nearest full slot, the terminal slot or the end if it does not point to one. Works in O(skipped slots) time.
+    IntHashMapIterator& skip() {
+        while (Index < Terminal && Keys[Index] == int_hash_map_empty_key<KeyType>()) {
+            ++Index;
+        }
+        return *this;
+    }
+    // Moves iterator to next item and returns it in O(1) expected time.
+    IntHashMapIterator& operator++() {
+        ++Index;
+        return skip();
+    }
+    // Moves iterator to next item and returns its previous state in O(1) expected time.
+    IntHashMapIterator operator++(int) {
+        IntHashMapIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    const KeyType* Keys = nullptr;
+    ValueType* Values = nullptr;
+    size_t Index = 0;
+    size_t Terminal = 0;
+};
+
+// Constant integral key hash table iterator implemented by storing key and value arrays and slot number.
+// Dereferencing returns a pair of constant references to the key and the value. Skips empty slots, guarantees iteration in O(capacity) time.
+template<class KeyType, class ValueType>
+class IntHashMapConstIterator {
+  public:
+    typedef std::pair<const KeyType&, const ValueType&> Reference;
+    // Pointer-like holder of a reference pair returned by operator->().
+    struct Pointer {
+        Reference Item;
+        const Reference* operator->() const {
+            return &Item;
+        }
+    };
+    // Default constructor.
+    IntHashMapConstIterator() {}
+    // Constructor by key and value arrays, slot number and number of the terminal slot.
+    IntHashMapConstIterator(const KeyType* k, const ValueType* v, size_t i, size_t t) {
+        Keys = k;
+        Values = v;
+        Index = i;
+        Terminal = t;
+    }
+    // Returns true if constant iterator is equal to Oth in O(1) time.
+    bool operator==(const IntHashMapConstIterator &Oth) const {
+        return Index == Oth.Index && Keys == Oth.Keys;
+    }
+    // Returns true if constant iterator is not equal to Oth in O(1) time.
+    bool operator!=(const IntHashMapConstIterator &Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns slot number in O(1) time.
+    size_t GetIndex() const {
+        return Index;
+    }
+    // Returns pair of constant references to key and value in O(1) time.
+    Reference operator*() const {
+        return Reference(Keys[Index], Values[Index]);
+    }
+    // Returns holder of pair of constant references to key and value in O(1) time.
+    Pointer operator->() const {
+        return Pointer{**this};
+    }
+    // Moves constant iterator to the nearest full slot, the terminal slot or the end if it does not point to one. Works in O(skipped slots) time.
+    IntHashMapConstIterator& skip() {
+        while (Index < Terminal && Keys[Index] == int_hash_map_empty_key<KeyType>()) {
+            ++Index;
+        }
+        return *this;
+    }
+    // Moves constant iterator to next item and returns it in O(1) expected time.
+    IntHashMapConstIterator& operator++() {
+        ++Index;
+        return skip();
+    }
+    // Moves constant iterator to next item and returns its previous state in O(1) expected time.
+    IntHashMapConstIterator operator++(int) {
+        IntHashMapConstIterator Old = *this;
+        operator++();
+        return Old;
     }
-    // Constructor for begin and end iterators.
-    template<class Iterator>
-    HashMap(Iterator first, Iterator last) {
-        initialize();
-        for (auto i = first; i != last; ++i) {
-            insert(*i);
+  private:
+    const KeyType* Keys = nullptr;
+    const ValueType* Values = nullptr;
+    size_t Index = 0;
+    size_t Terminal = 0;
+};
+
+// Hash map type for KeyType and ValueType: IntHashMap for integral keys other than bool, HashMap otherwise.
+template<class KeyType, class ValueType>
+using DefaultHashMap = typename std::conditional<std::is_integral<KeyType>::value && !std::is_same<KeyType, bool>::value,
+                                                 IntHashMap<KeyType, ValueType>, HashMap<KeyType, ValueType>>::type;
+
+// Thread safe hash map made of independently locked HashMap shards.
+// Key space is split by hash: high bits of the mixed hash choose the shard, so the low bits used by shard buckets stay
+// uniform. Every shard has its own reader-writer lock, so readers of a shard run in parallel, writers block only their
+// shard, and shards rehash on their own without stopping the rest of the map.
+// Items are never exposed by reference outside of a lock: lookups and updates take callbacks which run under the
+// shard lock (shared for cvisit, exclusive for visit and the insertion family). Callbacks must not access the same map.
+// Whole-map queries such as size() lock shards one by one, so concurrent updates may or may not be counted.
+// Shards are locked independently, so they allocate at the same time: shards may share an allocator only if it is
+// thread safe, and allocators of resources that are not, such as ArenaAllocator, need a resource per shard.
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>, class GrowthPolicy = PrimeGrowthPolicy,
+         class Allocator = std::allocator<std::pair<const KeyType, ValueType>>>
+class ConcurrentHashMap {
+    struct ShardVersion;
+  public:
+    typedef HashMap<KeyType, ValueType, Hash, KeyEqual, GrowthPolicy, Allocator> map_type;
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    // Consistent read-only view of every item at the moment of its creation.
+    // Keeps the maps which the shards had at that moment. The first writer to a shard whose map is kept by a snapshot
+    // copies the whole shard map, items included, in O(shard size) time and then changes only the copy. The copy is made
+    // without holding the shard lock, so readers of the shard do not wait for it, but writers of the shard do.
+    // Every shard is copied at most once per snapshot and only if it is written to, so while a snapshot lives,
+    // writes to every shard copy the whole map. Iteration and lookups take no locks.
+    class Snapshot {
+      public:
+        typedef ConcurrentHashMapSnapshotIterator<map_type> const_iterator;
+        typedef const_iterator iterator;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        // Move constructor in O(1) time.
+        Snapshot(Snapshot&& Oth) = default;
+        // Releases the kept maps, so writers change them in place again.
+        ~Snapshot() {
+            for (auto& v : Versions) {
+                v->Pins.fetch_sub(1, std::memory_order_release);
+            }
+        }
+        // Returns begin iterator pointing to the first item in O(shards) time.
+        const_iterator begin() const {
+            return const_iterator(Maps.data(), Maps.size(), 0);
+        }
+        // Returns end iterator in O(1) time.
+        const_iterator end() const {
+            return const_iterator(Maps.data(), Maps.size(), Maps.size());
+        }
+        // Returns number of items in O(1) time.
+        size_t size() const {
+            return Sz;
         }
+        // Returns true if the snapshot does not store any item in O(1) time.
+        bool empty() const {
+            return Sz == 0;
+        }
+        // Calls f with constant item by key in O(1) expected time. Returns false if there is no such item.
+        template<class F>
+        bool cvisit(const KeyType& Key, F&& f) const {
+            size_t h = HashFunction(Key);
+            const map_type& m = *Maps[shard_index(h, Maps.size())];
+            auto i = m.find(Key, h);
+            if (i == m.end()) {
+                return false;
+            }
+            f(*i);
+            return true;
+        }
+        // Returns copy of value by key or Default if there is no such item in O(1) expected time.
+        ValueType get(const KeyType& Key, const ValueType& Default = ValueType()) const {
+            ValueType Result = Default;
+            cvisit(Key, [&Result](const value_type& Item) { Result = Item.second; });
+            return Result;
+        }
+        // Returns number of items with key in O(1) expected time.
+        size_t count(const KeyType& Key) const {
+            return cvisit(Key, [](const value_type&) {});
+        }
+        // Returns true if an item with key is stored in O(1) expected time.
+        bool contains(const KeyType& Key) const {
+            return count(Key) != 0;
+        }
+      private:
+        friend class ConcurrentHashMap;
+        // Constructor with hash function of the map and place for n shards.
+        Snapshot(const Hash& HashFunction, size_t n): HashFunction(HashFunction) {
+            Versions.reserve(n);
+            Maps.reserve(n);
+        }
+        Hash HashFunction;
+        std::vector<std::shared_ptr<ShardVersion>> Versions;
+        std::vector<const map_type*> Maps;
+        size_t Sz = 0;
+    };
+    // Constructor with number of shards, rounded up to a power of two. Default count is 4 shards per hardware thread.
+    // Every shard gets a copy of Alloc, so it must be thread safe; give shards resources of their own with the constructor
+    // taking an allocator per shard otherwise.
+    explicit ConcurrentHashMap(size_t ShardCount = default_shard_count(), const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual(),
+                               const Allocator& Alloc = Allocator())
+        : ConcurrentHashMap(ShardCount, HashFunction, Equal, [&Alloc](size_t) { return Alloc; }) {
+        static_assert(IsThreadSafeAllocator<Allocator>::value, "shards can not share an allocator which is not thread safe, use an allocator per shard");
     }
-    // Constructor for initializer list.
-    HashMap(std::initializer_list<std::pair<KeyType, ValueType>> List) {
-        initialize();
-        for (auto i : List) {
-            insert(i);
+    // Constructor with number of shards, rounded up to a power of two, and allocator of every shard by its number,
+    // for example a PageAllocator of a PageResource placed on a NUMA node, so that each shard stays node-local.
+    // Allocators of different shards must not share a resource unless it is thread safe.
+    ConcurrentHashMap(size_t ShardCount, const Hash& HashFunction, const KeyEqual& Equal, const std::function<Allocator(size_t)>& ShardAllocator)
+        : HashFunction(HashFunction) {
+        ShardCount = ShardCount <= 1 ? 1 : 2 * highest_power_of_two(ShardCount - 1);
+        Shards.reserve(ShardCount);
+        for (size_t i = 0; i != ShardCount; ++i) {
+            Shards.emplace_back(new Shard(HashFunction, Equal, ShardAllocator(i)));
         }
     }
-    // Default constructor with custom hash function.
-    HashMap(const Hash& HashFunction): HashFunction(HashFunction) {
-        initialize();
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+    // Returns number of shards in O(1) time.
+    size_t shard_count() const {
+        return Shards.size();
     }
-    // Constructor for begin and end iterators with custom hash function.
-    template<class Iterator>
-    HashMap(Iterator first, Iterator last, const Hash& HashFunction): HashFunction(HashFunction) {
-        initialize();
-        for (auto i = first; i != last; ++i) {
-            insert(*i);
-        }
+    // Inserts copy of item if its key is absent in O(1) amortized time. Returns true if insertion took place.
+    bool insert(const value_type& Item) {
+        return emplace(Item);
     }
-    // Constructor for initializer list with custom hash function.
-    HashMap(std::initializer_list<std::pair<KeyType, ValueType>> List, const Hash& HashFunction): HashFunction(HashFunction) {
-        initialize();
-        for (auto i : List) {
-            insert(i);
+    // Inserts moved item if its key is absent in O(1) amortized time. Returns true if insertion took place.
+    bool insert(value_type&& Item) {
+        return emplace(std::move(Item));
+    }
+    // Inserts item constructed from args if its key is absent in O(1) amortized time. Returns true if insertion took place.
+    template<class... Args>
+    bool emplace(Args&&... args) {
+        std::pair<KeyType, ValueType> Item(std::forward<Args>(args)...);
+        Shard& s = get_shard(Item.first);
+        auto Lock = s.lock_writable();
+        return s.Version->Map.insert(std::move(Item)).second;
+    }
+    // Inserts item with key and value constructed from args if the key is absent in O(1) amortized time.
+    // Returns true if insertion took place. Does not construct the value otherwise.
+    template<class... Args>
+    bool try_emplace(const KeyType& Key, Args&&... args) {
+        Shard& s = get_shard(Key);
+        auto Lock = s.lock_writable();
+        return s.Version->Map.try_emplace(Key, std::forward<Args>(args)...).second;
+    }
+    // Assigns Obj to item by key or inserts a new item if the key is absent in O(1) amortized time.
+    // Returns true if insertion took place.
+    template<class M>
+    bool insert_or_assign(const KeyType& Key, M&& Obj) {
+        Shard& s = get_shard(Key);
+        auto Lock = s.lock_writable();
+        return s.Version->Map.insert_or_assign(Key, std::forward<M>(Obj)).second;
+    }
+    // Calls f with item by key under exclusive shard lock in O(1) amortized time, like operator[] does:
+    // if the key is absent, inserts an item with value constructed from args first. Returns true if insertion took place.
+    template<class F, class... Args>
+    bool try_emplace_and_visit(const KeyType& Key, F&& f, Args&&... args) {
+        Shard& s = get_shard(Key);
+        auto Lock = s.lock_writable();
+        auto Result = s.Version->Map.try_emplace(Key, std::forward<Args>(args)...);
+        f(*Result.first);
+        return Result.second;
+    }
+    // Calls f with item by key under exclusive shard lock, so f may change the value. Works in O(1) expected time.
+    // Returns false if there is no such item.
+    template<class F>
+    bool visit(const KeyType& Key, F&& f) {
+        size_t h = HashFunction(Key);
+        Shard& s = *Shards[shard_index(h)];
+        auto Lock = s.lock_writable();
+        map_type& m = s.Version->Map;
+        auto i = m.find(Key, h);
+        if (i == m.end()) {
+            return false;
         }
+        f(*i);
+        return true;
     }
-    // Returns begin iterator in O(1) time.
-    iterator begin() {
-        if (empty()) {
-            return end();
+    // Calls f with constant item by key under shared shard lock in O(1) expected time. Returns false if there is no such item.
+    template<class F>
+    bool cvisit(const KeyType& Key, F&& f) const {
+        size_t h = HashFunction(Key);
+        const Shard& s = *Shards[shard_index(h)];
+        std::shared_lock<std::shared_mutex> Lock(s.Mutex);
+        const map_type& m = s.Version->Map;
+        auto i = m.find(Key, h);
+        if (i == m.end()) {
+            return false;
         }
-        return get_iterator();
+        f(*i);
+        return true;
     }
-    // Returns end iterator in O(1) time.
-    iterator end() {
-        return get_iterator(Table.size());
+    // Returns copy of value by key or Default if there is no such item in O(1) expected time.
+    ValueType get(const KeyType& Key, const ValueType& Default = ValueType()) const {
+        ValueType Result = Default;
+        cvisit(Key, [&Result](const value_type& Item) { Result = Item.second; });
+        return Result;
     }
-    // Returns constanst begin iterator in O(1) time.
-    const_iterator begin() const {
-        if (empty()) {
-            return end();
+    // Returns number of items with key in O(1) expected time.
+    size_t count(const KeyType& Key) const {
+        const Shard& s = get_shard(Key);
+        std::shared_lock<std::shared_mutex> Lock(s.Mutex);
+        return s.Version->Map.count(Key);
+    }
+    // Returns true if an item with key is stored in O(1) expected time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
+    }
+    // Erases item by key in O(1) amortized time and returns number of erased items.
+    size_t erase(const KeyType& Key) {
+        Shard& s = get_shard(Key);
+        auto Lock = s.lock_writable();
+        return s.Version->Map.erase(Key);
+    }
+    // Returns number of stored items in O(shards) time.
+    size_t size() const {
+        size_t n = 0;
+        for (auto& s : Shards) {
+            std::shared_lock<std::shared_mutex> Lock(s->Mutex);
+            n += s->Version->Map.size();
         }
-        return get_iterator();
+        return n;
     }
-    // Returns constanst end iterator in O(1) time.
-    const_iterator end() const {
-        return get_iterator(Table.size());
+    // Returns true if the container does not store any item in O(shards) time.
+    bool empty() const {
+        return size() == 0;
     }
-    // Returns hash function in O(1) time.
-    Hash hash_function() const {
-        return HashFunction;
+    // Clears every shard in O(size + shards) time. Maps kept by snapshots are replaced with empty ones, not copied.
+    void clear() {
+        for (auto& s : Shards) {
+            std::unique_lock<std::shared_mutex> Lock(s->Mutex);
+            const map_type& m = s->Version->Map;
+            if (s->Version->Pins.load(std::memory_order_acquire) != 0) {
+                s->Version = std::make_shared<ShardVersion>(m.hash_function(), m.key_eq(), m.get_allocator());
+            } else {
+                s->Version->Map.clear();
+            }
+        }
     }
-    // Inserts item in O(1) amortized time. May invalidate iterators.
-    void insert(const std::pair<KeyType, ValueType>& Item) {
-        if (find(Item.first) != end()) {
-            return;
+    // Reserves place for n items spread evenly over shards in O(size + n) time.
+    void reserve(size_t n) {
+        for (auto& s : Shards) {
+            auto Lock = s->lock_writable();
+            s->Version->Map.reserve(n / Shards.size() + 1);
         }
-        add(Item);
-        if (is_dense()) {
-            resize(size() * ResizeFactor);
-        } else if (is_sparse()) {
-            resize(size() / ResizeFactor);
+    }
+    // Returns consistent snapshot of every item in O(shards) time without copying items. Later writes copy the maps
+    // of the shards they change while the snapshot lives, see Snapshot.
+    // Holds shared locks of all shards at once while taking it, so the snapshot sees either all or none of the changes
+    // of every other call, and writers wait for O(shards) time at most.
+    Snapshot snapshot() const {
+        Snapshot Result(HashFunction, Shards.size());
+        std::vector<std::shared_lock<std::shared_mutex>> Locks;
+        Locks.reserve(Shards.size());
+        for (auto& s : Shards) {
+            Locks.emplace_back(s->Mutex);
+            s->Version->Pins.fetch_add(1, std::memory_order_relaxed);
+            Result.Versions.push_back(s->Version);
+            Result.Maps.push_back(&s->Version->Map);
+            Result.Sz += s->Version->Map.size();
         }
+        return Result;
     }
-    // Erases item in O(1) amortized time. May invalidate iterators.
-    void erase(const KeyType& Key) {
-        del(Key);
-        if (is_dense()) {
-            resize(size() * ResizeFactor);
-        } else if (is_sparse()) {
-            resize(size() / ResizeFactor);
+    // Returns the default number of shards: 4 per hardware thread, rounded up to a power of two.
+    static size_t default_shard_count() {
+        size_t n = 4 * std::max(1u, std::thread::hardware_concurrency());
+        return 2 * highest_power_of_two(n - 1);
+    }
+
+  private:
+    // Map of a shard with number of snapshots keeping it. A kept map is never changed.
+    struct ShardVersion {
+        // Constructor by arguments of the map.
+        template<class... Args>
+        explicit ShardVersion(Args&&... args): Map(std::forward<Args>(args)...) {}
+        map_type Map;
+        std::atomic<size_t> Pins{0};
+    };
+    // Current map version with its lock. Aligned to cache line, so locks of neighbouring shards do not share one.
+    struct alignas(64) Shard {
+        // Constructor by hash function, key equality and allocator of the map.
+        Shard(const Hash& HashFunction, const KeyEqual& Equal, const Allocator& Alloc)
+            : Version(std::make_shared<ShardVersion>(HashFunction, Equal, Alloc)) {}
+        // Returns exclusive lock under which Version->Map may be changed. If a snapshot keeps the map, copies it first
+        // in O(shard size) time. The kept map does not change, so it is copied after unlocking, pinned by the copying writer
+        // itself; other writers wait until the copy is installed, readers do not.
+        std::unique_lock<std::shared_mutex> lock_writable() {
+            std::unique_lock<std::shared_mutex> Lock(Mutex);
+            while (Version->Pins.load(std::memory_order_acquire) != 0) {
+                if (Copying) {
+                    Copied.wait(Lock);
+                    continue;
+                }
+                std::shared_ptr<ShardVersion> Old = Version;
+                Old->Pins.fetch_add(1, std::memory_order_relaxed);
+                Copying = true;
+                Lock.unlock();
+                std::shared_ptr<ShardVersion> New;
+                try {
+                    New = std::make_shared<ShardVersion>(Old->Map);
+                } catch (...) {
+                    Lock.lock();
+                    finish_copy(*Old);
+                    throw;
+                }
+                Lock.lock();
+                finish_copy(*Old);
+                if (Version == Old) {
+                    Version = std::move(New);
+                }
+            }
+            return Lock;
         }
+        // Releases the pin of a copied version and wakes writers waiting for the copy. The lock must be held.
+        void finish_copy(ShardVersion& Old) {
+            Old.Pins.fetch_sub(1, std::memory_order_release);
+            Copying = false;
+            Copied.notify_all();
+        }
+        mutable std::shared_mutex Mutex;
+        std::shared_ptr<ShardVersion> Version;
+        // True while a writer copies a kept map after unlocking; other writers wait on Copied meanwhile.
+        bool Copying = false;
+        std::condition_variable_any Copied;
+    };
+    // Returns number of shard for hash function value h among n shards in O(1) time.
+    static size_t shard_index(size_t h, size_t n) {
+        return (MurmurHashMixer()(h) >> 32) & (n - 1);
     }
-    // Returns iterator of item by key in O(bucket size). If hash function is good, works in O(1) expected time.
-    iterator find(const KeyType& Key) {
-        if (empty()) {
-            return end();
+    // Returns number of shard for hash function value h in O(1) time.
+    size_t shard_index(size_t h) const {
+        return shard_index(h, Shards.size());
+    }
+    // Returns shard of key in O(1) time.
+    Shard& get_shard(const KeyType& Key) {
+        return *Shards[shard_index(HashFunction(Key))];
+    }
+    // Returns constant shard of key in O(1) time.
+    const Shard& get_shard(const KeyType& Key) const {
+        return *Shards[shard_index(HashFunction(Key))];
+    }
+    Hash HashFunction;
+    std::vector<std::unique_ptr<Shard>> Shards;
+};
+
+// Constant iterator of ConcurrentHashMap snapshot implemented by storing shard number and iterator of the shard map.
+// Skips empty shards, so iteration works in O(size + buckets / 64 + shards) time.
+template<class MapType>
+class ConcurrentHashMapSnapshotIterator {
+  public:
+    typedef typename MapType::value_type ValueType;
+    // Default constructor.
+    ConcurrentHashMapSnapshotIterator() {}
+    // Constructor by array of n shard maps and shard number. Points to the first item of that shard or a later one.
+    ConcurrentHashMapSnapshotIterator(const MapType* const* m, size_t n, size_t i): Maps(m), ShardCount(n), Shard(i) {
+        find_shard();
+    }
+    // Returns true if constant iterator is equal to Oth in O(1) time.
+    bool operator==(const ConcurrentHashMapSnapshotIterator& Oth) const {
+        return Shard == Oth.Shard && Maps == Oth.Maps && (Shard == ShardCount || Item == Oth.Item);
+    }
+    // Returns true if constant iterator is not equal to Oth in O(1) time.
+    bool operator!=(const ConcurrentHashMapSnapshotIterator& Oth) const {
+        return !(*this == Oth);
+    }
+    // Returns constant item reference in O(1) time.
+    const ValueType& operator*() const {
+        return *Item.operator->();
+    }
+    // Returns constant item pointer in O(1) time.
+    const ValueType* operator->() const {
+        return Item.operator->();
+    }
+    // Moves constant iterator to next item and returns it in O(1) expected time.
+    ConcurrentHashMapSnapshotIterator operator++() {
+        ++Item;
+        if (Item == Maps[Shard]->end()) {
+            ++Shard;
+            find_shard();
         }
-        size_t i = get_hash(Key);
-        for (size_t j = 0; j != Table[i].size(); ++j) {
-            if (Table[i][j].first == Key) {
-                return get_iterator(i, j);
+        return *this;
+    }
+    // Moves constant iterator to next item and returns its previous state in O(1) expected time.
+    ConcurrentHashMapSnapshotIterator operator++(int) {
+        ConcurrentHashMapSnapshotIterator Old = *this;
+        operator++();
+        return Old;
+    }
+  private:
+    // Moves to the first item of the current shard or a later one in O(skipped shards) time.
+    void find_shard() {
+        for (; Shard != ShardCount; ++Shard) {
+            if (!Maps[Shard]->empty()) {
+                Item = Maps[Shard]->begin();
+                return;
             }
         }
-        return end();
+        Item = typename MapType::const_iterator();
     }
-    // Returns constant iterator of item by key in O(bucket size). If hash function is good, works in O(1) expected time.
-    const_iterator find(const KeyType& Key) const {
-        if (empty()) {
-            return end();
+    const MapType* const* Maps = nullptr;
+    size_t ShardCount = 0, Shard = 0;
+    typename MapType::const_iterator Item;
+};
+
+// Epoch based memory reclamation for lock-free readers.
+// A reader announces the global epoch in its slot for the duration of a Guard. A writer retires memory it has unlinked
+// together with the current epoch and advances the epoch, so readers entering later can not reach that memory.
+// Retired memory is freed once every active reader announced a later epoch.
+// Readers only touch their own slot, which is cache line aligned, and read the global epoch, which changes once per
+// retire, so lookups of different threads do not write to shared cache lines.
+// Readers take one of ReaderSlotCount slots by thread index; more simultaneous readers wait for a slot to be released.
+// retire() and reclaim() must be serialized by the caller.
+class EpochReclaimer {
+  public:
+    static constexpr size_t ReaderSlotCount = 128;
+    // Number of retired objects that triggers an attempt to free them.
+    static constexpr size_t ReclaimThreshold = 64;
+    // Reader critical section: memory retired after it starts is not freed until it ends.
+    class Guard {
+      public:
+        // Announces current epoch of r in a free reader slot. Works in O(1) time if threads do not outnumber slots.
+        explicit Guard(const EpochReclaimer& r): Slot(r.enter()) {}
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        // Releases the reader slot.
+        ~Guard() {
+            Slot->store(0, std::memory_order_release);
+        }
+      private:
+        std::atomic<uint64_t>* Slot;
+    };
+    EpochReclaimer() = default;
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+    // Frees all retired objects. No reader may be active.
+    ~EpochReclaimer() {
+        for (auto& r : Retired) {
+            r.Free(r.Ptr);
+        }
+    }
+    // Schedules p, already unreachable for new readers, to be freed by Free once no reader can see it.
+    // Works in O(1) amortized time.
+    void retire(void* p, void (*Free)(void*)) {
+        Retired.push_back({GlobalEpoch.fetch_add(1), p, Free});
+        if (Retired.size() >= ReclaimThreshold) {
+            reclaim();
         }
-        size_t i = get_hash(Key);
-        for (size_t j = 0; j != Table[i].size(); ++j) {
-            if (Table[i][j].first == Key) {
-                return get_iterator(i, j);
+    }
+    // Frees retired objects which no active reader can see in O(slots + retired) time.
+    void reclaim() {
+        uint64_t MinEpoch = UINT64_MAX;
+        for (auto& s : Slots) {
+            uint64_t e = s.Epoch.load();
+            if (e != 0) {
+                MinEpoch = std::min(MinEpoch, e);
             }
         }
-        return end();
+        size_t Kept = 0;
+        for (auto& r : Retired) {
+            if (r.Epoch < MinEpoch) {
+                r.Free(r.Ptr);
+            } else {
+                Retired[Kept++] = r;
+            }
+        }
+        Retired.resize(Kept);
     }
-    // Clears table in O(size) time.
-    void clear() {
-        Sz = 0;
-        Table.clear();
-        initialize();
+  private:
+    // Epoch announced by a reader, or zero if the slot is free.
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> Epoch{0};
+    };
+    // Object waiting to be freed and the epoch it was retired in.
+    struct RetiredObject {
+        uint64_t Epoch;
+        void* Ptr;
+        void (*Free)(void*);
+    };
+    // Returns index of the calling thread in O(1) time. Indices are given out in order of first use.
+    static size_t thread_index() {
+        static std::atomic<size_t> NextIndex{0};
+        thread_local size_t Index = NextIndex.fetch_add(1, std::memory_order_relaxed);
+        return Index;
     }
-    // Assigns *this to Oth. Works in O(Oth.size + *this.size) time.
-    HashMap operator=(const HashMap& Oth) {
-        clear();
-        for (auto elem : Oth) {
-            insert(elem);
+    // Takes a free reader slot, starting from the one of the calling thread, and announces current epoch in it.
+    std::atomic<uint64_t>* enter() const {
+        for (size_t i = thread_index();; ++i) {
+            auto& Slot = Slots[i % ReaderSlotCount].Epoch;
+            uint64_t Free = 0;
+            if (Slot.load(std::memory_order_relaxed) == 0 && Slot.compare_exchange_strong(Free, GlobalEpoch.load())) {
+                return &Slot;
+            }
         }
-        return *this;
     }
-    // Returns item by key in O(1) time. If no items stored by this key, creates a new item.
-    ValueType& operator[](const KeyType& Key) {
-        auto j = find(Key);
-        if (j == end()) {
-            insert({Key, ValueType()});
-            j = find(Key);
+    mutable ReaderSlot Slots[ReaderSlotCount];
+    std::atomic<uint64_t> GlobalEpoch{1};
+    std::vector<RetiredObject> Retired;
+};
+
+// Concurrent hash map whose readers take no locks and write no shared memory.
+// Buckets are atomic heads of singly linked lists of nodes which are never changed once published. Writers are
+// serialized by a mutex and publish changes with single atomic stores of bucket heads: insertion links a new node at
+// the head, while erasure and assignment copy the nodes before the old one and link the copies to its successor or to
+// a copy with the new value. Growing builds a new table with twice the buckets, copies nodes into it and publishes it
+// with one atomic store; readers already in the old table finish their lookup there. Unlinked nodes and old tables are
+// freed through EpochReclaimer once no reader can see them.
+// Fits read-mostly workloads: every write takes the writer lock. Items are read through cvisit(), find(), get() and
+// snapshot().
+template<class KeyType, class ValueType, class Hash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>>
+class LockFreeReadHashMap {
+    struct Node;
+    struct Table;
+  public:
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<const KeyType, ValueType> value_type;
+    // Consistent read-only view of every item at the moment of its creation.
+    // Keeps the table of that moment: the next write copies its bucket heads, not the nodes, into a new table and
+    // changes only the new one. Holds an epoch guard, so nodes unlinked while the snapshot lives are freed after it ends.
+    // Iteration and lookups take no locks. A snapshot must not outlive its map.
+    class Snapshot {
+      public:
+        typedef LockFreeReadHashMapSnapshotIterator<Node> const_iterator;
+        typedef const_iterator iterator;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        // Releases the kept table, so writers change it in place again.
+        ~Snapshot() {
+            Kept->Pins.fetch_sub(1, std::memory_order_release);
+        }
+        // Returns begin iterator pointing to the first item in O(buckets) time.
+        const_iterator begin() const {
+            return const_iterator(Kept->Buckets.get(), Kept->Mask + 1, 0);
+        }
+        // Returns end iterator in O(1) time.
+        const_iterator end() const {
+            return const_iterator(Kept->Buckets.get(), Kept->Mask + 1, Kept->Mask + 1);
+        }
+        // Returns number of items in O(1) time.
+        size_t size() const {
+            return Sz;
+        }
+        // Returns true if the snapshot does not store any item in O(1) time.
+        bool empty() const {
+            return Sz == 0;
+        }
+        // Calls f with constant item by key in O(1) expected time. Returns false if there is no such item.
+        template<class F>
+        bool cvisit(const KeyType& Key, F&& f) const {
+            const Node* n = Map.find_node(Kept, Key);
+            if (n == nullptr) {
+                return false;
+            }
+            f(n->Item);
+            return true;
         }
-        return j->second;
+        // Returns copy of value by key or Default if there is no such item in O(1) expected time.
+        ValueType get(const KeyType& Key, const ValueType& Default = ValueType()) const {
+            const Node* n = Map.find_node(Kept, Key);
+            return n == nullptr ? Default : n->Item.second;
+        }
+        // Returns number of items with key in O(1) expected time.
+        size_t count(const KeyType& Key) const {
+            return Map.find_node(Kept, Key) != nullptr;
+        }
+        // Returns true if an item with key is stored in O(1) expected time.
+        bool contains(const KeyType& Key) const {
+            return count(Key) != 0;
+        }
+      private:
+        friend class LockFreeReadHashMap;
+        // Keeps the current table of map m. The writer lock of m must be held.
+        explicit Snapshot(const LockFreeReadHashMap& m): Guard(m.Reclaimer), Map(m), Kept(m.Current.load(std::memory_order_relaxed)), Sz(m.size()) {
+            Kept->Pins.fetch_add(1, std::memory_order_relaxed);
+        }
+        EpochReclaimer::Guard Guard;
+        const LockFreeReadHashMap& Map;
+        const Table* Kept;
+        size_t Sz;
+    };
+    // Constructor with custom hash function and key equality.
+    explicit LockFreeReadHashMap(const Hash& HashFunction = Hash(), const KeyEqual& Equal = KeyEqual())
+        : HashFunction(HashFunction), Equal(Equal), Current(new Table(1)) {}
+    LockFreeReadHashMap(const LockFreeReadHashMap&) = delete;
+    LockFreeReadHashMap& operator=(const LockFreeReadHashMap&) = delete;
+    // Destroys every item in O(size + buckets) time. No reader or writer may be active.
+    ~LockFreeReadHashMap() {
+        free_table(Current.load());
     }
-    // Returns item by key in O(1) time. If no items stored by this key, throws out of range exception. If an exception is thrown, there are no changes in the container.
-    const ValueType& at(const KeyType& Key) const {
-        auto j = find(Key);
-        if (j == end()) {
-            throw std::out_of_range("incorrect key");
+    // Calls f with constant item by key without locks in O(1) expected time. Returns false if there is no such item.
+    // The item stays valid during the call even if a writer erases it.
+    template<class F>
+    bool cvisit(const KeyType& Key, F&& f) const {
+        EpochReclaimer::Guard Guard(Reclaimer);
+        const Node* n = find_node(Key);
+        if (n == nullptr) {
+            return false;
+        }
+        f(n->Item);
+        return true;
+    }
+    // Returns copy of value by key, or nothing if there is no such item, without locks in O(1) expected time.
+    std::optional<ValueType> find(const KeyType& Key) const {
+        EpochReclaimer::Guard Guard(Reclaimer);
+        const Node* n = find_node(Key);
+        if (n == nullptr) {
+            return std::nullopt;
         }
-        return j->second;
+        return n->Item.second;
+    }
+    // Returns copy of value by key or Default if there is no such item without locks in O(1) expected time.
+    ValueType get(const KeyType& Key, const ValueType& Default = ValueType()) const {
+        EpochReclaimer::Guard Guard(Reclaimer);
+        const Node* n = find_node(Key);
+        return n == nullptr ? Default : n->Item.second;
+    }
+    // Returns number of items with key without locks in O(1) expected time.
+    size_t count(const KeyType& Key) const {
+        EpochReclaimer::Guard Guard(Reclaimer);
+        return find_node(Key) != nullptr;
+    }
+    // Returns true if an item with key is stored without locks in O(1) expected time.
+    bool contains(const KeyType& Key) const {
+        return count(Key) != 0;
     }
     // Returns number of stored items in O(1) time.
     size_t size() const {
-        return Sz;
+        return Sz.load(std::memory_order_relaxed);
     }
     // Returns true if the container does not store any item in O(1) time.
     bool empty() const {
-        return Sz == 0;
-    }
-
-  private:
-    // Resizes table to one bucket.
-    void initialize() {
-        Table.resize(1);
+        return size() == 0;
     }
-    // Returns hash function of a key in O(1) time.
-    size_t get_hash(const KeyType& Key) const {
-        return HashFunction(Key) % Table.size();
+    // Returns number of buckets in O(1) time.
+    size_t bucket_count() const {
+        return Current.load(std::memory_order_acquire)->Mask + 1;
     }
-    // Returns iterator for bucket of number f and item of number s in the bucket in O(1) time.
-    iterator get_iterator(size_t f = 0, size_t s = 0) {
-        return iterator(&Table, f, s);
+    // Inserts copy of item if its key is absent in O(1) amortized time. Returns true if insertion took place.
+    bool insert(const value_type& Item) {
+        return try_emplace(Item.first, Item.second);
     }
-    // Returns constant iterator for bucket of number f and item of number s in the bucket in O(1) time.
-    const_iterator get_iterator(size_t f = 0, size_t s = 0) const {
-        return const_iterator(&Table, f, s);
+    // Inserts item constructed from args if its key is absent in O(1) amortized time. Returns true if insertion took place.
+    template<class... Args>
+    bool emplace(Args&&... args) {
+        std::pair<KeyType, ValueType> Item(std::forward<Args>(args)...);
+        return try_emplace(Item.first, std::move(Item.second));
     }
-    // Inserts item in bucket of its hash in O(1) time.
-    void add(const std::pair<KeyType, ValueType>& Item) {
-        ++Sz;
-        size_t i = get_hash(Item.first);
-        Table[i].push_back(Item);
+    // Inserts item with key and value constructed from args if the key is absent in O(1) amortized time.
+    // Returns true if insertion took place.
+    template<class... Args>
+    bool try_emplace(const KeyType& Key, Args&&... args) {
+        std::lock_guard<std::mutex> Lock(WriterMutex);
+        if (find_node(Key) != nullptr) {
+            return false;
+        }
+        add(Key, std::forward<Args>(args)...);
+        return true;
     }
-    // Erases item from bucket of its hash in O(bucket size) time. If hash function is good, works in expected O(1) time.
-    void del(const KeyType& Key) {
-        size_t i = get_hash(Key);
-        std::vector<std::pair<const KeyType, ValueType>> NewBucket;
-        for (auto elem : Table[i]) {
-            if (elem.first != Key) {
-                NewBucket.push_back(elem);
-            }
+    // Assigns Obj to item by key or inserts a new item if the key is absent in O(1) amortized time.
+    // Readers see either the old or the new item. Returns true if insertion took place.
+    template<class M>
+    bool insert_or_assign(const KeyType& Key, M&& Obj) {
+        std::lock_guard<std::mutex> Lock(WriterMutex);
+        Node* Old = const_cast<Node*>(find_node(Key));
+        if (Old == nullptr) {
+            add(Key, std::forward<M>(Obj));
+            return true;
         }
-        if (NewBucket.size() != Table[i].size()) {
-            swap(Table[i], NewBucket);
-            --Sz;
+        replace_node(get_bucket(writable_table(), HashFunction(Key)), Old,
+                     new Node(Old->Next.load(std::memory_order_relaxed), Key, std::forward<M>(Obj)));
+        return false;
+    }
+    // Erases item by key in O(1) expected time and returns number of erased items.
+    size_t erase(const KeyType& Key) {
+        std::lock_guard<std::mutex> Lock(WriterMutex);
+        Node* Old = const_cast<Node*>(find_node(Key));
+        if (Old == nullptr) {
+            return 0;
         }
+        replace_node(get_bucket(writable_table(), HashFunction(Key)), Old, Old->Next.load(std::memory_order_relaxed));
+        Sz.fetch_sub(1, std::memory_order_relaxed);
+        return 1;
     }
-    // Returns true if number of items stored is more than product of load factor and buckets number.
-    bool is_dense() {
-        return size() > Table.size() * LoadFactor;
+    // Erases every item in O(size) time by publishing an empty table.
+    void clear() {
+        std::lock_guard<std::mutex> Lock(WriterMutex);
+        Table* Old = Current.load(std::memory_order_relaxed);
+        Current.store(new Table(1), std::memory_order_release);
+        Sz.store(0, std::memory_order_relaxed);
+        Reclaimer.retire(Old, free_table);
     }
-    // Returns true if product of number of items stored and load factor is less than buckets number.
-    bool is_sparse() {
-        return size() * LoadFactor < Table.size();
+    // Returns consistent snapshot of every item in O(1) time without copying items. Takes the writer lock for O(1) time.
+    Snapshot snapshot() const {
+        std::lock_guard<std::mutex> Lock(WriterMutex);
+        return Snapshot(*this);
     }
-    // Changes number of buckets to n in O(size + n) time.
-    void resize(size_t n) {
-        Sz = 0;
-        std::vector<std::vector<std::pair<const KeyType, ValueType>>> OldTable;
-        swap(OldTable, Table);
-        Table.resize(n);
-        for (auto& Bucket : OldTable) {
-            for (auto& Item : Bucket) {
-                add(Item);
-            }
-        }
-        if (Table.size() == 0) {
-            initialize();
+    // Grows table to fit n items without further growth in O(size + n) time.
+    void reserve(size_t n) {
+        std::lock_guard<std::mutex> Lock(WriterMutex);
+        if (n > bucket_count()) {
+            migrate(2 * highest_power_of_two(n - 1));
         }
     }
-    Hash HashFunction;
-    std::vector<std::vector<std::pair<const KeyType, ValueType>>> Table;
-    size_t Sz = 0;
-};
 
-// Hash table iterator implemented by storing bucket and item numbers.
-// Guarantees iteration in O(size) time.
-template<class ValueType>
-class HashMapIterator {
-  public:
-    // Default constructor.
-    HashMapIterator() {}
-    // Constructor by table, bucket number and item number.
-    HashMapIterator(typename std::vector<std::vector<ValueType>>* t, size_t f, size_t s) {
-        First = f;
-        Second = s;
-        Table = t;
+  private:
+    // List node, not changed once published.
+    struct Node {
+        // Constructor by next node and arguments of the item.
+        template<class... Args>
+        explicit Node(Node* n, Args&&... args): Item(std::forward<Args>(args)...), Next(n) {}
+        value_type Item;
+        std::atomic<Node*> Next;
+    };
+    // Power-of-two array of bucket heads with number of snapshots keeping it. A kept table is never changed.
+    struct Table {
+        // Constructor with n empty buckets.
+        explicit Table(size_t n): Mask(n - 1), Buckets(new std::atomic<Node*>[n]()) {}
+        size_t Mask;
+        std::unique_ptr<std::atomic<Node*>[]> Buckets;
+        mutable std::atomic<size_t> Pins{0};
+    };
+    // Returns bucket head of hash h in table t in O(1) time.
+    static std::atomic<Node*>& get_bucket(const Table* t, size_t h) {
+        return t->Buckets[MurmurHashMixer()(h) & t->Mask];
     }
-    // Returns true if iterator is equal to Oth in O(1) time.
-    bool operator==(const HashMapIterator &Oth) const {
-        return First == Oth.first && Second == Oth.second && Table == Oth.Table;
+    // Returns node of item by key in table t or nullptr in O(bucket size) time. Readers must hold an epoch guard.
+    const Node* find_node(const Table* t, const KeyType& Key) const {
+        for (const Node* n = get_bucket(t, HashFunction(Key)).load(std::memory_order_acquire); n != nullptr; n = n->Next.load(std::memory_order_acquire)) {
+            if (Equal(n->Item.first, Key)) {
+                return n;
+            }
+        }
+        return nullptr;
     }
-    // Returns true if iterator is not equal to Oth in O(1) time.
-    bool operator!=(const HashMapIterator &Oth) const {
-        return !(*this == Oth);
+    // Returns node of item by key in the current table or nullptr in O(bucket size) time.
+    // Readers must hold an epoch guard.
+    const Node* find_node(const KeyType& Key) const {
+        return find_node(Current.load(std::memory_order_acquire), Key);
     }
-    // Returns bucket number in O(1) time.
-    size_t GetFirst() {
-        return First;
+    // Returns the current table for changing in O(1) time. If a snapshot keeps it, publishes a new table with copied
+    // bucket heads in O(buckets) time first; the old table is retired without its nodes, which the new one shares.
+    // For writers.
+    Table* writable_table() {
+        Table* t = Current.load(std::memory_order_relaxed);
+        if (t->Pins.load(std::memory_order_acquire) == 0) {
+            return t;
+        }
+        Table* New = new Table(t->Mask + 1);
+        for (size_t i = 0; i <= t->Mask; ++i) {
+            New->Buckets[i].store(t->Buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        Current.store(New, std::memory_order_release);
+        Reclaimer.retire(t, free_buckets);
+        return New;
     }
-    // Returns item number in bucket in O(1) time.
-    size_t GetSecond() {
-        return Second;
+    // Publishes list of bucket Head with node Old replaced by list Rest in O(bucket size) time. Nodes before Old are
+    // copied, since readers and snapshots may still walk them; they and Old are retired. For writers.
+    void replace_node(std::atomic<Node*>& Head, Node* Old, Node* Rest) {
+        std::vector<Node*> Before;
+        for (Node* n = Head.load(std::memory_order_relaxed); n != Old; n = n->Next.load(std::memory_order_relaxed)) {
+            Before.push_back(n);
+        }
+        for (size_t i = Before.size(); i-- != 0; ) {
+            Rest = new Node(Rest, Before[i]->Item);
+        }
+        Head.store(Rest, std::memory_order_release);
+        for (Node* n : Before) {
+            Reclaimer.retire(n, free_node);
+        }
+        Reclaimer.retire(Old, free_node);
     }
-    // Returns item object in O(1) time.
-    ValueType& operator*() {
-        return (*Table)[First][Second];
+    // Links a new item at its bucket head, growing the table first if it would become dense. For writers.
+    template<class... Args>
+    void add(const KeyType& Key, Args&&... args) {
+        Table* t = Current.load(std::memory_order_relaxed);
+        if (size() + 1 > t->Mask + 1) {
+            migrate(2 * (t->Mask + 1));
+        }
+        t = writable_table();
+        std::atomic<Node*>& Bucket = get_bucket(t, HashFunction(Key));
+        Bucket.store(new Node(Bucket.load(std::memory_order_relaxed), std::piecewise_construct, std::forward_as_tuple(Key),
+                              std::forward_as_tuple(std::forward<Args>(args)...)), std::memory_order_release);
+        Sz.fetch_add(1, std::memory_order_relaxed);
     }
-    // Returns constant item object in O(1) time.
-    ValueType operator*() const {
-        return (*Table)[First][Second];
+    // Publishes a copy of the current table with n buckets and retires the old one in O(size + n) time.
+    // Nodes are copied, since readers may still walk the old lists. For writers.
+    void migrate(size_t n) {
+        Table* Old = Current.load(std::memory_order_relaxed);
+        Table* New = new Table(n);
+        for (size_t i = 0; i <= Old->Mask; ++i) {
+            for (Node* p = Old->Buckets[i].load(std::memory_order_relaxed); p != nullptr; p = p->Next.load(std::memory_order_relaxed)) {
+                std::atomic<Node*>& Bucket = get_bucket(New, HashFunction(p->Item.first));
+                Bucket.store(new Node(Bucket.load(std::memory_order_relaxed), p->Item), std::memory_order_relaxed);
+            }
+        }
+        Current.store(New, std::memory_order_release);
+        Reclaimer.retire(Old, free_table);
     }
-    // Returns item reference in O(1) time.
-    ValueType* operator->() {
-        return &(*Table)[First][Second];
+    // Frees node p.
+    static void free_node(void* p) {
+        delete static_cast<Node*>(p);
     }
-    // Returns constant item reference in O(1) time.
-    ValueType const* operator->() const {
-        return &(*Table)[First][Second];
+    // Frees table p without its nodes.
+    static void free_buckets(void* p) {
+        delete static_cast<Table*>(p);
     }
-    // Moves iterator to next item and returns it in O(1) expected time.
-    HashMapIterator operator++() {
-        ++Second;
-        if (Second >= (*Table)[First].size()) {
-            ++First;
-            while (First != Table->size() && (*Table)[First].size() == 0) {
-                ++First;
+    // Frees table p with every node still linked in it.
+    static void free_table(void* p) {
+        Table* t = static_cast<Table*>(p);
+        for (size_t i = 0; i <= t->Mask; ++i) {
+            for (Node* n = t->Buckets[i].load(std::memory_order_relaxed); n != nullptr; ) {
+                Node* Next = n->Next.load(std::memory_order_relaxed);
+                delete n;
+                n = Next;
             }
-            Second = 0;
         }
-        return *this;
-    }
-    // Moves iterator to next item and returns its previous state in O(1) expected time.
-    HashMapIterator operator++(int) {
-        HashMapIterator Old = *this;
-        operator++();
-        return Old;
+        delete t;
     }
-  private:
-    typename std::vector<std::vector<ValueType>>* Table;
-    size_t First, Second;
+    Hash HashFunction;
+    KeyEqual Equal;
+    std::atomic<Table*> Current;
+    std::atomic<size_t> Sz{0};
+    mutable std::mutex WriterMutex;
+    mutable EpochReclaimer Reclaimer;
 };
 
-// Constant hash table iterator implemented by storing bucket and item numbers.
-// Guarantees iteration in O(size) time.
-template<class ValueType>
-class HashMapConstIterator {
+// Constant iterator of LockFreeReadHashMap snapshot implemented by storing bucket number and node pointer.
+// Iteration works in O(size + buckets) time.
+template<class NodeType>
+class LockFreeReadHashMapSnapshotIterator {
   public:
+    typedef decltype(NodeType::Item) ValueType;
     // Default constructor.
-    HashMapConstIterator() {}
-    // Constructor by table, bucket number and item number.
-    HashMapConstIterator(const std::vector<std::vector<ValueType>>* t, size_t f, size_t s) {
-        First = f;
-        Second = s;
-        Table = t;
+    LockFreeReadHashMapSnapshotIterator() {}
+    // Constructor by array of n bucket heads and bucket number. Points to the first item of that bucket or a later one.
+    LockFreeReadHashMapSnapshotIterator(const std::atomic<NodeType*>* b, size_t n, size_t i): Buckets(b), BucketCount(n), Bucket(i) {
+        find_bucket();
     }
     // Returns true if constant iterator is equal to Oth in O(1) time.
-    bool operator==(const HashMapConstIterator &Oth) const {
-        return First == Oth.first && Second == Oth.second && Table == Oth.Table;
+    bool operator==(const LockFreeReadHashMapSnapshotIterator& Oth) const {
+        return Current == Oth.Current && Bucket == Oth.Bucket && Buckets == Oth.Buckets;
     }
     // Returns true if constant iterator is not equal to Oth in O(1) time.
-    bool operator!=(const HashMapConstIterator &Oth) const {
+    bool operator!=(const LockFreeReadHashMapSnapshotIterator& Oth) const {
         return !(*this == Oth);
     }
-    // Returns bucket number in O(1) time.
-    size_t GetFirst() {
-        return First;
-    }
-    // Returns item number in bucket in O(1) time.
-    size_t GetSecond() {
-        return Second;
-    }
-    // Returns constant item object in O(1) time.
-    ValueType operator*() const {
-        return (*Table)[First][Second];
-    }
     // Returns constant item reference in O(1) time.
-    ValueType const* operator->() const {
-        return &(*Table)[First][Second];
+    const ValueType& operator*() const {
+        return Current->Item;
+    }
+    // Returns constant item pointer in O(1) time.
+    const ValueType* operator->() const {
+        return &Current->Item;
     }
     // Moves constant iterator to next item and returns it in O(1) expected time.
-    HashMapConstIterator operator++() {
-        ++Second;
-        if (Second >= (*Table)[First].size()) {
-            ++First;
-            while (First != Table->size() && (*Table)[First].size() == 0) {
-                ++First;
-            }
-            Second = 0;
+    LockFreeReadHashMapSnapshotIterator operator++() {
+        Current = Current->Next.load(std::memory_order_acquire);
+        if (Current == nullptr) {
+            ++Bucket;
+            find_bucket();
         }
         return *this;
     }
     // Moves constant iterator to next item and returns its previous state in O(1) expected time.
-    HashMapConstIterator operator++(int) {
-        HashMapConstIterator Old = *this;
+    LockFreeReadHashMapSnapshotIterator operator++(int) {
+        LockFreeReadHashMapSnapshotIterator Old = *this;
         operator++();
         return Old;
     }
   private:
-    const std::vector<std::vector<ValueType>>* Table;
-    size_t First, Second;
+    // Moves to the first node of the current bucket or a later one in O(skipped buckets) time.
+    void find_bucket() {
+        for (; Bucket != BucketCount; ++Bucket) {
+            Current = Buckets[Bucket].load(std::memory_order_acquire);
+            if (Current != nullptr) {
+                return;
+            }
+        }
+    }
+    const std::atomic<NodeType*>* Buckets = nullptr;
+    size_t BucketCount = 0, Bucket = 0;
+    const NodeType* Current = nullptr;
 };
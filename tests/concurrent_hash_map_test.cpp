@@ -0,0 +1,128 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "task1.cpp"
+
+// Tests of the thread safe maps and of HashMap::parallel_insert under real concurrency, also built with
+// ThreadSanitizer when the compiler supports it. Checks stay on in release builds, unlike assert().
+#define CHECK(Condition)                                                                        \
+    do {                                                                                        \
+        if (!(Condition)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition); \
+            std::exit(1);                                                                       \
+        }                                                                                       \
+    } while (false)
+
+namespace {
+
+constexpr size_t ThreadCount = 4;
+// Number of keys written by every writer thread.
+constexpr size_t KeyCount = 10000;
+
+// Returns value stored by writers for key k, so that readers can check any value they see.
+uint64_t value_of(uint64_t k) {
+    return k * 3 + 1;
+}
+
+// Runs f(i) on ThreadCount threads and waits for them.
+template<class F>
+void run_threads(F&& f) {
+    std::vector<std::thread> Threads;
+    for (size_t i = 0; i != ThreadCount; ++i) {
+        Threads.emplace_back([&f, i] { f(i); });
+    }
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+}
+
+// Writers insert keys of their own and of a range shared by all of them and erase every third own key, while readers
+// look keys up and take snapshots. Afterwards Map must hold exactly the surviving keys.
+template<class Map>
+void test_thread_safe_map() {
+    Map Map_;
+    std::atomic<size_t> Writers(ThreadCount);
+    std::vector<std::thread> Readers;
+    for (size_t r = 0; r != 2; ++r) {
+        Readers.emplace_back([&Map_, &Writers] {
+            uint64_t k = 0;
+            while (Writers.load() != 0) {
+                uint64_t v = Map_.get(k % (ThreadCount * KeyCount), 0);
+                CHECK(v == 0 || v == value_of(k % (ThreadCount * KeyCount)));
+                if (++k % 16384 == 0) {
+                    auto Snapshot = Map_.snapshot();
+                    for (const auto& Item : Snapshot) {
+                        CHECK(Item.second == value_of(Item.first));
+                    }
+                }
+            }
+        });
+    }
+    std::atomic<size_t> SharedInserted(0);
+    run_threads([&](size_t t) {
+        for (uint64_t i = 0; i != KeyCount; ++i) {
+            uint64_t k = t * KeyCount + i;
+            CHECK(Map_.try_emplace(k, value_of(k)));
+            SharedInserted += Map_.try_emplace(ThreadCount * KeyCount + i, value_of(ThreadCount * KeyCount + i));
+            if (i % 3 == 0) {
+                CHECK(Map_.erase(k) == 1);
+            }
+        }
+        --Writers;
+    });
+    for (auto& Reader : Readers) {
+        Reader.join();
+    }
+    CHECK(SharedInserted.load() == KeyCount);
+    size_t Expected = KeyCount;
+    for (uint64_t k = 0; k != ThreadCount * KeyCount; ++k) {
+        bool Erased = k % KeyCount % 3 == 0;
+        CHECK(Map_.contains(k) != Erased);
+        Expected += !Erased;
+    }
+    CHECK(Map_.size() == Expected);
+}
+
+// Inserts items on several threads with parallel_insert() and compares the map with std::unordered_map.
+template<class Map>
+void test_parallel_insert(Map&& Map_) {
+    std::vector<std::pair<uint64_t, uint64_t>> Items;
+    std::unordered_map<uint64_t, uint64_t> Reference;
+    for (uint64_t i = 0; i != ThreadCount * KeyCount; ++i) {
+        // Repeated keys keep their first value, as with insertion one by one.
+        uint64_t k = MurmurHashMixer()(i % (ThreadCount * KeyCount * 3 / 4));
+        Items.emplace_back(k, i);
+        Reference.emplace(k, i);
+    }
+    Map_.try_emplace(Items[0].first, Items[0].second);
+    Map_.parallel_insert(Items.begin(), Items.end(), ThreadCount);
+    CHECK(Map_.size() == Reference.size());
+    for (const auto& Item : Reference) {
+        auto i = Map_.find(Item.first);
+        CHECK(i != Map_.end() && i->second == Item.second);
+    }
+}
+
+} // namespace
+
+int main() {
+    test_thread_safe_map<ConcurrentHashMap<uint64_t, uint64_t>>();
+    test_thread_safe_map<LockFreeReadHashMap<uint64_t, uint64_t>>();
+    test_parallel_insert(HashMap<uint64_t, uint64_t>());
+    PageResource Pages(HugePages::None);
+    test_parallel_insert(HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PrimeGrowthPolicy,
+                                 PageAllocator<std::pair<const uint64_t, uint64_t>>>(
+        PageAllocator<std::pair<const uint64_t, uint64_t>>(Pages)));
+    MonotonicArena Arena;
+    test_parallel_insert(HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PrimeGrowthPolicy,
+                                 ArenaAllocator<std::pair<const uint64_t, uint64_t>>>(
+        ArenaAllocator<std::pair<const uint64_t, uint64_t>>(Arena)));
+    std::puts("ok");
+    return 0;
+}
@@ -0,0 +1,614 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "task1.cpp"
+
+// Differential tests of every map against std::unordered_map, and round trips of saved maps through mapped views.
+// Checks stay on in release builds, unlike assert().
+#define CHECK(Condition)                                                                        \
+    do {                                                                                        \
+        if (!(Condition)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition); \
+            std::exit(1);                                                                       \
+        }                                                                                       \
+    } while (false)
+
+namespace {
+
+// Number of random operations of every differential round.
+constexpr size_t OperationCount = 20000;
+
+// Returns key number i of a range small enough for operations to hit existing keys often.
+template<class Key>
+Key make_key(uint64_t i);
+
+// Key 0 becomes the key with all bits set, which IntHashMap keeps apart from the table as its empty key.
+template<>
+uint64_t make_key<uint64_t>(uint64_t i) {
+    return i == 0 ? ~uint64_t(0) : i;
+}
+
+template<>
+std::string make_key<std::string>(uint64_t i) {
+    return "key/" + std::to_string(i);
+}
+
+// Returns true if Map holds exactly the items of Reference, checked both by lookups and by iteration.
+template<class Map, class Key, class Value>
+bool same_items(const Map& Map_, const std::unordered_map<Key, Value>& Reference) {
+    if (Map_.size() != Reference.size() || Map_.empty() != Reference.empty()) {
+        return false;
+    }
+    for (const auto& Item : Reference) {
+        auto i = Map_.find(Item.first);
+        if (i == Map_.end() || !(i->second == Item.second) || Map_.count(Item.first) != 1) {
+            return false;
+        }
+    }
+    size_t n = 0;
+    for (auto i = Map_.begin(); i != Map_.end(); ++i, ++n) {
+        auto j = Reference.find(i->first);
+        if (j == Reference.end() || !(j->second == i->second)) {
+            return false;
+        }
+    }
+    return n == Reference.size();
+}
+
+// True if Map erases ranges of iterators.
+template<class Map, class = void>
+struct HasRangeErase: std::false_type {};
+template<class Map>
+struct HasRangeErase<Map, std::void_t<decltype(std::declval<Map&>().erase(std::declval<Map&>().begin(), std::declval<Map&>().end()))>>: std::true_type {};
+
+// Erases up to three items starting at the item by key k from Map and Reference, checking the iterator erase() returns.
+template<class Map, class Key, class Value>
+void erase_range(Map& Map_, std::unordered_map<Key, Value>& Reference, const Key& k) {
+    auto First = Map_.find(k);
+    auto Last = First;
+    for (size_t i = 0; i != 3 && Last != Map_.end(); ++i, ++Last) {
+        Reference.erase(Last->first);
+    }
+    bool AtEnd = Last == Map_.end();
+    Key Next = AtEnd ? k : Key(Last->first);
+    auto i = Map_.erase(First, Last);
+    CHECK(AtEnd ? i == Map_.end() : i != Map_.end() && i->first == Next);
+}
+
+// Runs random insertions, assignments, erases and lookups on Map and on std::unordered_map and compares them.
+// Map_ is an empty map to start from, which may carry an allocator.
+template<class Map>
+void test_map(uint64_t Seed, Map Map_ = Map()) {
+    typedef typename Map::key_type Key;
+    typedef typename Map::mapped_type Value;
+    std::mt19937_64 Random(Seed);
+    std::unordered_map<Key, Value> Reference;
+    for (size_t Operation = 0; Operation != OperationCount; ++Operation) {
+        Key k = make_key<Key>(Random() % 2000);
+        Value v = static_cast<Value>(Random());
+        switch (Random() % 8) {
+        case 0:
+        case 1:
+            CHECK(Map_.try_emplace(k, v).second == Reference.try_emplace(k, v).second);
+            break;
+        case 2:
+            CHECK(Map_.insert_or_assign(k, v).second == Reference.insert_or_assign(k, v).second);
+            break;
+        case 3:
+            Map_[k] = v;
+            Reference[k] = v;
+            break;
+        case 4:
+            CHECK(Map_.erase(k) == Reference.erase(k));
+            break;
+        case 5: {
+            auto i = Map_.find(k);
+            CHECK((i == Map_.end()) == (Reference.count(k) == 0));
+            if (i != Map_.end()) {
+                Map_.erase(i);
+                Reference.erase(k);
+            }
+            break;
+        }
+        case 6:
+            CHECK(Map_.contains(k) == (Reference.count(k) != 0));
+            if constexpr (HasRangeErase<Map>::value) {
+                if (Reference.count(k) != 0 && Random() % 8 == 0) {
+                    erase_range(Map_, Reference, k);
+                }
+            }
+            break;
+        default:
+            if (Random() % 1000 == 0) {
+                Map_.clear();
+                Reference.clear();
+            }
+            break;
+        }
+        CHECK(Map_.size() == Reference.size());
+    }
+    CHECK(same_items(Map_, Reference));
+    Map Copy = Map_;
+    CHECK(same_items(Copy, Reference));
+    Map Moved = std::move(Copy);
+    CHECK(same_items(Moved, Reference));
+    Map_.reserve(Map_.size() * 4);
+    CHECK(same_items(Map_, Reference));
+}
+
+// Runs random updates and lookups on thread safe Map from one thread and compares it with std::unordered_map.
+template<class Map>
+void test_thread_safe_map(uint64_t Seed) {
+    std::mt19937_64 Random(Seed);
+    Map Map_;
+    std::unordered_map<uint64_t, uint64_t> Reference;
+    for (size_t Operation = 0; Operation != OperationCount; ++Operation) {
+        uint64_t k = Random() % 2000;
+        uint64_t v = Random();
+        switch (Random() % 5) {
+        case 0:
+        case 1:
+            CHECK(Map_.try_emplace(k, v) == Reference.try_emplace(k, v).second);
+            break;
+        case 2:
+            CHECK(Map_.insert_or_assign(k, v) == Reference.insert_or_assign(k, v).second);
+            break;
+        case 3:
+            CHECK(Map_.erase(k) == Reference.erase(k));
+            break;
+        default: {
+            auto i = Reference.find(k);
+            CHECK(Map_.contains(k) == (i != Reference.end()));
+            CHECK(Map_.get(k, 1) == (i != Reference.end() ? i->second : 1));
+            break;
+        }
+        }
+    }
+    CHECK(Map_.size() == Reference.size());
+    auto Snapshot = Map_.snapshot();
+    size_t n = 0;
+    for (const auto& Item : Snapshot) {
+        CHECK(Reference.at(Item.first) == Item.second);
+        ++n;
+    }
+    CHECK(n == Reference.size());
+}
+
+// Builds immutable Map of random items and compares it with std::unordered_map.
+template<class Map>
+void test_frozen_map(uint64_t Seed) {
+    std::mt19937_64 Random(Seed);
+    for (size_t n : {0, 1, 7, 1000, 50000}) {
+        std::unordered_map<uint64_t, uint64_t> Reference;
+        while (Reference.size() != n) {
+            Reference.emplace(Random(), Random());
+        }
+        Map Map_(Reference.begin(), Reference.end());
+        CHECK(same_items(Map_, Reference));
+        for (size_t i = 0; i != 1000; ++i) {
+            uint64_t k = Random();
+            CHECK(Map_.count(k) == Reference.count(k));
+        }
+    }
+}
+
+void test_constant_map() {
+    constexpr auto Map_ = make_constant_hash_map<int, int>({{1, 10}, {2, 20}, {30, 300}, {-4, 40}});
+    static_assert(Map_.at(30) == 300, "constant lookup");
+    const std::unordered_map<int, int> Reference = {{1, 10}, {2, 20}, {30, 300}, {-4, 40}};
+    CHECK(same_items(Map_, Reference));
+    CHECK(Map_.count(3) == 0);
+}
+
+// Looks up std::string keys of transparent Map by std::string_view and C string, without constructing std::string keys.
+template<class Map>
+void test_transparent_lookup() {
+    Map Map_;
+    for (uint64_t i = 0; i != 100; ++i) {
+        Map_[make_key<std::string>(i)] = i;
+    }
+    std::string Buffer = make_key<std::string>(42) + "/suffix";
+    std::string_view Key(Buffer.data(), Buffer.size() - 7);
+    CHECK(Map_.find(Key) != Map_.end() && Map_.find(Key)->second == 42);
+    CHECK(Map_.at(Key) == 42 && Map_.count(Key) == 1 && Map_.contains(Key));
+    CHECK(Map_.contains("key/7") && !Map_.contains(std::string_view(Buffer)));
+    CHECK(Map_.erase(Key) == 1 && !Map_.contains(Key) && Map_.size() == 99);
+}
+
+// Compares find_batch() and contains_batch() of Map with lookups of single keys, on hits and misses.
+template<class Map>
+void test_batch_lookup(uint64_t Seed) {
+    std::mt19937_64 Random(Seed);
+    Map Map_;
+    for (size_t i = 0; i != 5000; ++i) {
+        Map_[Random() % 20000] = i;
+    }
+    std::vector<uint64_t> Keys;
+    for (size_t i = 0; i != 1001; ++i) {
+        Keys.push_back(Random() % 20000);
+    }
+    std::vector<typename Map::iterator> Found;
+    Map_.find_batch(Keys.begin(), Keys.end(), std::back_inserter(Found));
+    std::vector<typename Map::const_iterator> ConstFound;
+    static_cast<const Map&>(Map_).find_batch(Keys.begin(), Keys.end(), std::back_inserter(ConstFound));
+    std::vector<bool> Contained;
+    Map_.contains_batch(Keys.begin(), Keys.end(), std::back_inserter(Contained));
+    CHECK(Found.size() == Keys.size() && ConstFound.size() == Keys.size() && Contained.size() == Keys.size());
+    for (size_t i = 0; i != Keys.size(); ++i) {
+        CHECK(Found[i] == Map_.find(Keys[i]) && ConstFound[i] == static_cast<const Map&>(Map_).find(Keys[i]));
+        CHECK(Contained[i] == Map_.contains(Keys[i]));
+    }
+}
+
+// Checks that stats() of Map agree with its items and buckets.
+template<class Map>
+void test_stats(uint64_t Seed) {
+    std::mt19937_64 Random(Seed);
+    Map Map_;
+    CHECK(Map_.stats().Size == 0 && Map_.stats().MaxChainLength == 0);
+    for (size_t i = 0; i != 10000; ++i) {
+        Map_[Random()] = i;
+    }
+    HashMapStats Stats = Map_.stats();
+    CHECK(Stats.Size == Map_.size() && Stats.BucketCount == Map_.bucket_count());
+    CHECK(std::accumulate(Stats.ChainLengths.begin(), Stats.ChainLengths.end(), size_t(0)) == Stats.BucketCount);
+    size_t Items = 0;
+    for (size_t k = 0; k != Stats.ChainLengths.size(); ++k) {
+        Items += k * Stats.ChainLengths[k];
+    }
+    CHECK(Items == Stats.Size && Stats.ChainLengths.size() == Stats.MaxChainLength + 1);
+    CHECK(Stats.OccupiedBuckets == Stats.BucketCount - Stats.ChainLengths[0]);
+    CHECK(Stats.BucketCollisions == Stats.Size - Stats.OccupiedBuckets && Stats.AllocatedBytes != 0);
+    CHECK(Stats.average_successful_probes() >= 1 && Stats.hash_collision_rate() >= 0);
+}
+
+// Compares merge(), erase_if() and for_each() of HashMap with std::unordered_map::merge() and erasing loops.
+template<class Map>
+void test_bulk_operations(uint64_t Seed) {
+    std::mt19937_64 Random(Seed);
+    Map Map_, Oth;
+    std::unordered_map<uint64_t, uint64_t> Reference, ReferenceOth;
+    for (size_t i = 0; i != 4000; ++i) {
+        uint64_t k = Random() % 6000;
+        uint64_t v = Random();
+        Map_.try_emplace(k, v);
+        Reference.try_emplace(k, v);
+        k = Random() % 6000;
+        Oth.try_emplace(k, v);
+        ReferenceOth.try_emplace(k, v);
+    }
+    Map_.merge(Oth);
+    Reference.merge(ReferenceOth);
+    CHECK(same_items(Map_, Reference) && same_items(Oth, ReferenceOth));
+    Map Empty;
+    Empty.merge(std::move(Map_));
+    CHECK(same_items(Empty, Reference) && Map_.empty());
+    CHECK(Empty.erase_if([](const auto& Item) { return Item.second % 3 == 0; }) ==
+          static_cast<size_t>(std::count_if(Reference.begin(), Reference.end(), [](const auto& Item) { return Item.second % 3 == 0; })));
+    for (auto i = Reference.begin(); i != Reference.end();) {
+        i = i->second % 3 == 0 ? Reference.erase(i) : std::next(i);
+    }
+    CHECK(same_items(Empty, Reference));
+    Empty.for_each([](auto& Item) { ++Item.second; });
+    for (auto& Item : Reference) {
+        ++Item.second;
+    }
+    uint64_t Sum = 0;
+    static_cast<const Map&>(Empty).for_each([&Sum](const auto& Item) { Sum += Item.first ^ Item.second; });
+    uint64_t ReferenceSum = 0;
+    for (const auto& Item : Reference) {
+        ReferenceSum += Item.first ^ Item.second;
+    }
+    CHECK(same_items(Empty, Reference) && Sum == ReferenceSum);
+}
+
+// Hash function with equal hashes for every key, as in a flooding attack.
+struct ConstantKeyHash {
+    size_t operator()(uint64_t) const {
+        return 42;
+    }
+    size_t operator()(const std::string&) const {
+        return 42;
+    }
+};
+
+// Inserts keys with equal hashes into HashMap, which must switch to keyed hashing, so that chains stay short.
+template<class Key>
+void test_flood_defense() {
+    HashMap<Key, uint64_t, ConstantKeyHash> Map_;
+    for (uint64_t i = 0; i != 5000; ++i) {
+        Map_[make_key<Key>(i)] = i;
+    }
+    for (uint64_t i = 0; i != 5000; ++i) {
+        CHECK(Map_.at(make_key<Key>(i)) == i);
+    }
+    CHECK(!Map_.contains(make_key<Key>(5000)) && Map_.stats().MaxChainLength < 64);
+}
+
+// Checks that OrderedHashMap iterates in insertion order after erases by key, by iterator and by range, and after compaction.
+void test_ordered_map_order(uint64_t Seed) {
+    std::mt19937_64 Random(Seed);
+    OrderedHashMap<uint64_t, uint64_t> Map_;
+    std::vector<std::pair<uint64_t, uint64_t>> Reference;
+    auto Position = [&Reference](uint64_t k) {
+        return std::find_if(Reference.begin(), Reference.end(), [k](const auto& Item) { return Item.first == k; });
+    };
+    auto SameOrder = [&Map_, &Reference]() {
+        auto i = Reference.begin();
+        for (const auto& Item : Map_) {
+            if (i == Reference.end() || Item.first != i->first || Item.second != i->second) {
+                return false;
+            }
+            ++i;
+        }
+        return i == Reference.end() && Map_.size() == Reference.size();
+    };
+    for (size_t Operation = 0; Operation != OperationCount; ++Operation) {
+        uint64_t k = Random() % 500;
+        auto i = Position(k);
+        switch (Random() % 4) {
+        case 0:
+        case 1:
+            CHECK(Map_.try_emplace(k, Operation).second == (i == Reference.end()));
+            if (i == Reference.end()) {
+                Reference.emplace_back(k, Operation);
+            }
+            break;
+        case 2:
+            CHECK(Map_.erase(k) == (i != Reference.end()));
+            if (i != Reference.end()) {
+                Reference.erase(i);
+            }
+            break;
+        default:
+            if (i != Reference.end()) {
+                auto Last = Map_.find(k);
+                size_t n = 0;
+                for (; n != 3 && Last != Map_.end(); ++n) {
+                    ++Last;
+                }
+                Map_.erase(Map_.find(k), Last);
+                Reference.erase(i, i + n);
+            }
+            break;
+        }
+        if (Operation % 1000 == 0) {
+            CHECK(SameOrder());
+        }
+    }
+    Map_.reserve(Map_.size() * 4);
+    CHECK(SameOrder());
+}
+
+// Mixer leaving keys as they are, so that keys differing only in high bits collide under every seed.
+struct IdentityKeyMixer {
+    size_t operator()(size_t x) const {
+        return x;
+    }
+};
+
+// Inserts keys that no seed separates into IntHashMap, which must throw length error instead of growing without bound.
+// Items inserted before keep their values.
+void test_int_map_collisions() {
+    IntHashMap<uint64_t, uint64_t, IdentityKeyMixer> Map_;
+    uint64_t n = 0;
+    bool Thrown = false;
+    try {
+        for (; n != 100000; ++n) {
+            Map_[n << 40] = n;
+        }
+    } catch (const std::length_error&) {
+        Thrown = true;
+    }
+    CHECK(Thrown && Map_.size() == n && Map_.bucket_count() < 100000);
+    for (uint64_t i = 0; i != n; ++i) {
+        CHECK(Map_.at(i << 40) == i);
+    }
+}
+
+// Number of value copies left before ThrowingValue throws.
+int CopyBudget = 0;
+
+// Value whose copy constructor throws once CopyBudget runs out. Owns heap memory, so that destroying a value which was
+// never constructed frees a wild pointer even without sanitizers.
+struct ThrowingValue {
+    uint64_t Value = 0;
+    std::string Text = std::string(32, 'x');
+    ThrowingValue(uint64_t Value = 0): Value(Value) {}
+    ThrowingValue(const ThrowingValue& Oth): Value(Oth.Value), Text(Oth.Text) {
+        if (CopyBudget-- <= 0) {
+            throw std::runtime_error("copy");
+        }
+    }
+    ThrowingValue(ThrowingValue&&) noexcept = default;
+    ThrowingValue& operator=(const ThrowingValue&) = default;
+    ThrowingValue& operator=(ThrowingValue&&) noexcept = default;
+};
+
+// Copies Map of values whose copies throw partway through: the failed copy must free everything, and if Strong,
+// the failed copy assignment must leave the target unchanged. Leaks and double destruction are left to ASan.
+template<class Map, bool Strong>
+void test_throwing_copy() {
+    CopyBudget = 1 << 30;
+    Map Map_;
+    for (uint64_t i = 0; i != 200; ++i) {
+        Map_[make_key<uint64_t>(i)] = ThrowingValue(i);
+    }
+    Map Target;
+    for (uint64_t i = 1000; i != 1010; ++i) {
+        Target[i] = ThrowingValue(i);
+    }
+    CopyBudget = 50;
+    bool Thrown = false;
+    try {
+        Map Copy(Map_);
+    } catch (const std::runtime_error&) {
+        Thrown = true;
+    }
+    CHECK(Thrown);
+    CopyBudget = 50;
+    Thrown = false;
+    try {
+        Target = Map_;
+    } catch (const std::runtime_error&) {
+        Thrown = true;
+    }
+    CHECK(Thrown);
+    CopyBudget = 1 << 30;
+    if (Strong) {
+        CHECK(Target.size() == 10);
+        for (uint64_t i = 1000; i != 1010; ++i) {
+            CHECK(Target.at(i).Value == i);
+        }
+    }
+    Target = Map_;
+    CHECK(Target.size() == 200);
+    for (uint64_t i = 0; i != 200; ++i) {
+        CHECK(Target.at(make_key<uint64_t>(i)).Value == i);
+    }
+}
+
+// Returns name of a temporary file for a map of this process.
+std::string temporary_path(const char* Name) {
+    return "hash_map_test_" + std::to_string(getpid()) + "_" + Name + ".map";
+}
+
+void test_save_and_open_mapped(uint64_t Seed) {
+    std::mt19937_64 Random(Seed);
+    std::string Path = temporary_path("hash_map");
+    std::string FrozenPath = temporary_path("frozen_hash_map");
+    for (size_t n : {0, 1, 100, 50000}) {
+        std::unordered_map<uint64_t, double> Reference;
+        while (Reference.size() != n) {
+            uint64_t k = Random();
+            Reference.emplace(k, static_cast<double>(k % 1000) / 8);
+        }
+        HashMap<uint64_t, double> Map_(Reference.begin(), Reference.end());
+        Map_.save(Path);
+        auto Mapped = HashMap<uint64_t, double>::open_mapped(Path);
+        CHECK(Mapped.size() == n);
+        for (const auto& Item : Reference) {
+            CHECK(Mapped.at(Item.first) == Item.second);
+        }
+        size_t Items = 0;
+        for (const auto& Item : Mapped) {
+            CHECK(Reference.at(Item.first) == Item.second);
+            ++Items;
+        }
+        CHECK(Items == n);
+
+        FrozenHashMap<uint64_t, double> Frozen(Reference.begin(), Reference.end());
+        Frozen.save(FrozenPath);
+        auto MappedFrozen = FrozenHashMap<uint64_t, double>::open_mapped(FrozenPath);
+        CHECK(MappedFrozen.size() == n);
+        for (const auto& Item : Reference) {
+            CHECK(MappedFrozen.at(Item.first) == Item.second);
+        }
+        Items = 0;
+        for (const auto& Item : MappedFrozen) {
+            CHECK(Reference.at(Item.first) == Item.second);
+            ++Items;
+        }
+        CHECK(Items == n);
+        for (size_t i = 0; i != 1000; ++i) {
+            uint64_t k = Random();
+            CHECK(Mapped.count(k) == Reference.count(k) && MappedFrozen.count(k) == Reference.count(k));
+        }
+
+        // Both formats share the magic number, so each view must reject the other by version.
+        bool Rejected = false;
+        try {
+            MappedHashMap<uint64_t, double> Wrong(FrozenPath);
+        } catch (const std::runtime_error&) {
+            Rejected = true;
+        }
+        CHECK(Rejected);
+        Rejected = false;
+        try {
+            MappedFrozenHashMap<uint64_t, double> Wrong(Path);
+        } catch (const std::runtime_error&) {
+            Rejected = true;
+        }
+        CHECK(Rejected);
+    }
+    std::remove(Path.c_str());
+    std::remove(FrozenPath.c_str());
+}
+
+// Item type and allocators of maps tested with memory resources.
+typedef std::pair<const uint64_t, uint64_t> item_type;
+typedef ArenaAllocator<item_type> arena_allocator_type;
+typedef PoolAllocator<item_type> pool_allocator_type;
+
+} // namespace
+
+int main() {
+    for (uint64_t Seed = 1; Seed != 4; ++Seed) {
+        test_map<HashMap<uint64_t, uint64_t>>(Seed);
+        test_map<HashMap<std::string, uint64_t>>(Seed);
+        test_map<HashMap<std::string, uint64_t, TransparentStringHash, std::equal_to<>>>(Seed);
+        test_map<HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PowerOfTwoGrowthPolicy<>>>(Seed);
+        test_map<HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, LinearGrowthPolicy<>>>(Seed);
+        test_map<HashMap<std::string, uint64_t, std::hash<std::string>, std::equal_to<std::string>, PrimeGrowthPolicy,
+                         std::allocator<std::pair<const std::string, uint64_t>>, true>>(Seed);
+        test_map<SmallHashMap<uint64_t, uint64_t>>(Seed);
+        test_map<SmallHashMap<std::string, uint64_t>>(Seed);
+        test_map<FlatHashMap<uint64_t, uint64_t>>(Seed);
+        test_map<FlatHashMap<std::string, uint64_t>>(Seed);
+        test_map<FlatHashMap<std::string, uint64_t, std::hash<std::string>, std::equal_to<std::string>,
+                             std::allocator<std::pair<const std::string, uint64_t>>, true>>(Seed);
+        test_map<OrderedHashMap<uint64_t, uint64_t>>(Seed);
+        test_map<OrderedHashMap<std::string, uint64_t>>(Seed);
+        test_map<IntHashMap<uint64_t, uint64_t>>(Seed);
+        {
+            MonotonicArena Arena;
+            FixedSizePool Pool;
+            test_map(Seed, HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PrimeGrowthPolicy, arena_allocator_type>(
+                               arena_allocator_type(Arena)));
+            test_map(Seed, HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PrimeGrowthPolicy, pool_allocator_type>(
+                               pool_allocator_type(Pool)));
+            test_map(Seed, FlatHashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, arena_allocator_type>(arena_allocator_type(Arena)));
+            test_map(Seed, OrderedHashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, pool_allocator_type>(pool_allocator_type(Pool)));
+            test_map(Seed, IntHashMap<uint64_t, uint64_t, MurmurHashMixer, arena_allocator_type>(arena_allocator_type(Arena)));
+        }
+        test_batch_lookup<HashMap<uint64_t, uint64_t>>(Seed);
+        test_batch_lookup<FlatHashMap<uint64_t, uint64_t>>(Seed);
+        test_stats<HashMap<uint64_t, uint64_t>>(Seed);
+        test_stats<HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, LinearGrowthPolicy<>>>(Seed);
+        test_bulk_operations<HashMap<uint64_t, uint64_t>>(Seed);
+        test_bulk_operations<HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PrimeGrowthPolicy,
+                                     std::allocator<item_type>, true>>(Seed);
+        test_ordered_map_order(Seed);
+        test_thread_safe_map<ConcurrentHashMap<uint64_t, uint64_t>>(Seed);
+        test_thread_safe_map<LockFreeReadHashMap<uint64_t, uint64_t>>(Seed);
+        test_frozen_map<FrozenHashMap<uint64_t, uint64_t>>(Seed);
+        test_save_and_open_mapped(Seed);
+    }
+    test_transparent_lookup<HashMap<std::string, uint64_t, TransparentStringHash, std::equal_to<>>>();
+    test_transparent_lookup<SmallHashMap<std::string, uint64_t, 8, TransparentStringHash, std::equal_to<>>>();
+    test_transparent_lookup<FlatHashMap<std::string, uint64_t, TransparentStringHash, std::equal_to<>>>();
+    test_transparent_lookup<OrderedHashMap<std::string, uint64_t, TransparentStringHash, std::equal_to<>>>();
+    test_flood_defense<uint64_t>();
+    test_flood_defense<std::string>();
+    test_int_map_collisions();
+    test_throwing_copy<HashMap<uint64_t, ThrowingValue>, true>();
+    test_throwing_copy<SmallHashMap<uint64_t, ThrowingValue>, false>();
+    test_throwing_copy<FlatHashMap<uint64_t, ThrowingValue>, true>();
+    test_throwing_copy<OrderedHashMap<uint64_t, ThrowingValue>, false>();
+    test_throwing_copy<IntHashMap<uint64_t, ThrowingValue>, true>();
+    test_constant_map();
+    std::puts("ok");
+    return 0;
+}